@@ -41,6 +41,9 @@
 # endif
 # include <stdlib.h>
 # include <stdint.h>
+# include <time.h>
+
+# include "simd.h"
 
 # ifndef MAX
 #  define MAX(a,b) ((a) > (b) ? (a) : (b))
@@ -60,6 +63,26 @@
                                MAX (sizeof (uintmax_t),			      \
                                     sizeof (void *)))
 
+/* Tails of abandoned chunks smaller than OBSTACK_TAIL_MIN bytes are not
+   worth remembering, and only objects of at most OBSTACK_TAIL_MAX bytes
+   are carved from them, so that large objects keep going to the current
+   chunk.  */
+#ifndef OBSTACK_TAIL_MIN
+# define OBSTACK_TAIL_MIN 64
+#endif
+#ifndef OBSTACK_TAIL_MAX
+# define OBSTACK_TAIL_MAX 256
+#endif
+
+/* Each object carved from a tail is preceded by a header recording where
+   the main chain stood when it was allocated, so that freeing it can
+   also release everything allocated after it.  This is the header size,
+   rounded up so the object stays aligned.  The header itself is only as
+   aligned as the objects, which may be less than a pointer needs, so it
+   is copied in and out with memcpy.  */
+#define TAIL_HEADER(h) ((sizeof (char *) + (h)->alignment_mask)		      \
+                        & ~(size_t) (h)->alignment_mask)
+
 /* Call functions with either the traditional malloc/free calling
    interface, or the mmalloc/mfree interface (that adds an extra first
    argument), based on the value of use_extra_arg.  */
@@ -82,6 +105,68 @@ call_freefun (struct obstack *h, void *old_chunk)
     h->freefun.plain (old_chunk);
 }
 
+/* Recompute the largest object that one of the tails of H can take.  */
+
+static void
+update_tail_room (struct obstack *h)
+{
+  struct _obstack_tail *t;
+  size_t room = 0;
+
+  for (t = h->tails; t < h->tails + _OBSTACK_NTAILS; t++)
+    if (t->limit && (size_t) (t->limit - t->next_free) > room)
+      room = t->limit - t->next_free;
+  room = room > TAIL_HEADER (h) ? room - TAIL_HEADER (h) : 0;
+  h->tail_room = room < OBSTACK_TAIL_MAX ? room : OBSTACK_TAIL_MAX;
+}
+
+/* Forget any tails that lie in CHUNK, which is about to be freed or to
+   become the current chunk again.  */
+
+static void
+drop_tails (struct obstack *h, struct _obstack_chunk *chunk)
+{
+  struct _obstack_tail *t;
+
+  for (t = h->tails; t < h->tails + _OBSTACK_NTAILS; t++)
+    if (t->limit && t->base > (char *) chunk && t->limit <= chunk->limit)
+      t->limit = 0;
+  update_tail_room (h);
+}
+
+/* Remember the unused space from the current object base to the end of
+   CHUNK, which is no longer current, replacing the smallest remembered
+   tail if all slots are taken.  CHUNK keeps a mark of where its tail
+   starts even if the slot is later reused, so that objects carved from
+   it are still recognized when freed.  */
+
+static void
+remember_tail (struct obstack *h, struct _obstack_chunk *chunk)
+{
+  char *base = h->object_base;
+  char *limit = chunk->limit;
+  struct _obstack_tail *t, *victim = h->tails;
+
+  if ((size_t) (limit - base) < OBSTACK_TAIL_MIN)
+    return;
+  for (t = h->tails; t < h->tails + _OBSTACK_NTAILS; t++)
+    {
+      if (!t->limit)
+        {
+          victim = t;
+          break;
+        }
+      if (t->limit - t->next_free < victim->limit - victim->next_free)
+        victim = t;
+    }
+  if (victim->limit && victim->limit - victim->next_free >= limit - base)
+    return;
+  victim->base = victim->next_free = base;
+  victim->limit = limit;
+  chunk->tail = base;
+  update_tail_room (h);
+}
+
 
 /* Initialize an obstack H for use.  Specify chunk size SIZE (0 means default).
    Objects start on multiples of ALIGNMENT (0 means use default).
@@ -124,9 +209,16 @@ _obstack_begin_worker (struct obstack *h,
                                                alignment - 1);
   h->chunk_limit = chunk->limit = (char *) chunk + h->chunk_size;
   chunk->prev = 0;
+  chunk->tail = 0;
+  memset (h->tails, 0, sizeof h->tails);
+  h->tail_room = 0;
   /* The initial chunk now contains no empty object.  */
   h->maybe_empty_object = 0;
   h->alloc_failed = 0;
+  h->failed_handler = 0;
+  h->memory_used = h->chunk_size;
+  h->soft_limit = h->hard_limit = 0;
+  h->soft_limit_handler = 0;
   return 1;
 }
 
@@ -160,10 +252,13 @@ _obstack_begin_1 (struct obstack *h,
    on the assumption that LENGTH bytes need to be added
    to the current object, or a new object of length LENGTH allocated.
    Copies any partial object from the end of the old chunk
-   to the beginning of the new one.  */
+   to the beginning of the new one.
 
-void
-_obstack_newchunk (struct obstack *h, _OBSTACK_SIZE_T length)
+   Return nonzero if successful.  Otherwise set H->alloc_failed and
+   return 0, leaving the obstack as it was.  */
+
+int
+_obstack_try_newchunk (struct obstack *h, _OBSTACK_SIZE_T length)
 {
   struct _obstack_chunk *old_chunk = h->chunk;
   struct _obstack_chunk *new_chunk = 0;
@@ -179,21 +274,29 @@ _obstack_newchunk (struct obstack *h, _OBSTACK_SIZE_T length)
   if (new_size < h->chunk_size)
     new_size = h->chunk_size;
 
-  /* Allocate and initialize the new chunk.  */
-  if (obj_size <= sum1 && sum1 <= sum2)
+  /* Allocate and initialize the new chunk, unless that would break the
+     hard limit.  */
+  if (obj_size <= sum1 && sum1 <= sum2
+      && (!h->hard_limit || (h->memory_used <= h->hard_limit
+                             && new_size <= h->hard_limit - h->memory_used)))
     new_chunk = call_chunkfun (h, new_size);
   if (!new_chunk)
-    (*obstack_alloc_failed_handler)();
+    {
+      h->alloc_failed = 1;
+      return 0;
+    }
   h->chunk = new_chunk;
   new_chunk->prev = old_chunk;
+  new_chunk->tail = 0;
   new_chunk->limit = h->chunk_limit = (char *) new_chunk + new_size;
+  h->memory_used += new_size;
 
   /* Compute an aligned object_base in the new chunk */
   object_base =
     __PTR_ALIGN ((char *) new_chunk, new_chunk->contents, h->alignment_mask);
 
   /* Move the existing object to the new chunk.  */
-  memcpy (object_base, h->object_base, obj_size);
+  simd_memcpy (object_base, h->object_base, obj_size);
 
   /* If the object just copied was the only data in OLD_CHUNK,
      free that chunk and remove it from the chain.
@@ -204,13 +307,70 @@ _obstack_newchunk (struct obstack *h, _OBSTACK_SIZE_T length)
                           h->alignment_mask)))
     {
       new_chunk->prev = old_chunk->prev;
+      h->memory_used -= old_chunk->limit - (char *) old_chunk;
       call_freefun (h, old_chunk);
     }
+  /* Otherwise the space the object vacated is free for small objects.  */
+  else
+    remember_tail (h, old_chunk);
 
   h->object_base = object_base;
   h->next_free = h->object_base + obj_size;
   /* The new chunk certainly contains no empty object yet.  */
   h->maybe_empty_object = 0;
+
+  if (h->soft_limit && h->memory_used > h->soft_limit
+      && h->soft_limit_handler)
+    h->soft_limit_handler (h);
+  return 1;
+}
+
+/* Like _obstack_try_newchunk, but report failure through the failed
+   handler of H.  */
+
+void
+_obstack_newchunk (struct obstack *h, _OBSTACK_SIZE_T length)
+{
+  if (!_obstack_try_newchunk (h, length))
+    _obstack_alloc_failed (h);
+}
+
+/* Allocate a finished object of LENGTH bytes from one of the remembered
+   tails of H, or return 0 if an object is growing or no tail has room.
+   The macros call this only for LENGTH up to H->tail_room.  */
+
+void *
+_obstack_tail_alloc (struct obstack *h, _OBSTACK_SIZE_T length)
+{
+  struct _obstack_tail *t, *best = 0;
+  size_t need = TAIL_HEADER (h) + length;
+  char *value;
+
+  if (h->next_free != h->object_base)
+    return 0;
+
+  /* Best fit, so that the roomiest tail survives for later objects.  */
+  for (t = h->tails; t < h->tails + _OBSTACK_NTAILS; t++)
+    if (t->limit && (size_t) (t->limit - t->next_free) >= need
+        && (!best || t->limit - t->next_free < best->limit - best->next_free))
+      best = t;
+  if (!best)
+    return 0;
+
+  /* The header points to where the next main-chain object will start.
+     If that is the start of the current chunk, _obstack_newchunk must
+     not free the chunk under it.  */
+  if (h->next_free == __PTR_ALIGN ((char *) h->chunk, h->chunk->contents,
+                                   h->alignment_mask))
+    h->maybe_empty_object = 1;
+  value = best->next_free + TAIL_HEADER (h);
+  memcpy (value - sizeof (char *), &h->next_free, sizeof (char *));
+  best->next_free = __PTR_ALIGN (best->base, value + length,
+                                 h->alignment_mask);
+  if (best->next_free > best->limit)
+    best->next_free = best->limit;
+  update_tail_room (h);
+  return value;
 }
 
 /* Return nonzero if object OBJ has been allocated from obstack H.
@@ -247,6 +407,33 @@ _obstack_free (struct obstack *h, void *obj)
 {
   struct _obstack_chunk *lp;    /* below addr of any objects in this chunk */
   struct _obstack_chunk *plp;   /* point to previous chunk if any */
+  struct _obstack_tail *t;
+
+  lp = h->chunk;
+  while (lp != 0 && ((void *) lp >= obj || (void *) (lp)->limit < obj))
+    lp = lp->prev;
+
+  /* An object carved from a tail gives its space back to the tail, and
+     everything allocated after it in the main chain goes as well.
+     Nothing else in the tail's chunk is affected.  */
+  if (lp && lp->tail && (char *) obj > lp->tail)
+    {
+      char *mark;
+
+      for (t = h->tails; t < h->tails + _OBSTACK_NTAILS; t++)
+        if (t->limit && t->base == lp->tail && (char *) obj < t->next_free)
+          {
+            t->next_free = (char *) obj - TAIL_HEADER (h);
+            update_tail_room (h);
+          }
+      memcpy (&mark, (char *) obj - sizeof mark, sizeof mark);
+      if (mark > (char *) h->chunk && mark <= h->chunk_limit)
+        {
+          h->next_free = h->object_base = mark;
+          return;
+        }
+      obj = mark;
+    }
 
   lp = h->chunk;
   /* We use >= because there cannot be an object at the beginning of a chunk.
@@ -255,6 +442,8 @@ _obstack_free (struct obstack *h, void *obj)
   while (lp != 0 && ((void *) lp >= obj || (void *) (lp)->limit < obj))
     {
       plp = lp->prev;
+      drop_tails (h, lp);
+      h->memory_used -= lp->limit - (char *) lp;
       call_freefun (h, lp);
       lp = plp;
       /* If we switch chunks, we can't tell whether the new current
@@ -263,6 +452,8 @@ _obstack_free (struct obstack *h, void *obj)
     }
   if (lp)
     {
+      drop_tails (h, lp);
+      lp->tail = 0;
       h->object_base = h->next_free = (char *) (obj);
       h->chunk_limit = lp->limit;
       h->chunk = lp;
@@ -272,17 +463,105 @@ _obstack_free (struct obstack *h, void *obj)
     abort ();
 }
 
-_OBSTACK_SIZE_T
-_obstack_memory_used (struct obstack *h)
+/* Free every object in H, like obstack_free (H, 0), but without freeing
+   any chunk right away.  H keeps its current chunk, emptied, and stays
+   ready for use; the older chunks move to R, to be freed a few at a time
+   by obstack_release_step, so the cost of this call does not depend on
+   how much H had grown.  The chunks count towards the memory H uses, and
+   its hard limit, until they are freed, so H must outlive them.  R may
+   already hold chunks from an earlier call on H, but not from another
+   obstack.  */
+
+void
+obstack_detach (struct obstack *h, struct obstack_release *r)
+{
+  struct _obstack_chunk *chain = h->chunk->prev;
+
+  h->chunk->prev = 0;
+  h->chunk->tail = 0;
+  h->next_free = h->object_base
+    = __PTR_ALIGN ((char *) h->chunk, h->chunk->contents, h->alignment_mask);
+  h->maybe_empty_object = 0;
+  memset (h->tails, 0, sizeof h->tails);
+  h->tail_room = 0;
+
+  if (!chain)
+    return;
+  r->owner = h;
+  r->freefun.extra = h->freefun.extra;
+  r->extra_arg = h->extra_arg;
+  r->use_extra_arg = h->use_extra_arg;
+  if (!r->chunk)
+    r->chunk = chain;
+  else
+    {
+      chain->tail = (char *) r->more;
+      r->more = chain;
+    }
+}
+
+/* Free chunks held by R: first those of the first call to
+   obstack_detach on R, then those of later calls, most recent call
+   first, and within each call the newest chunk first.  Stop after
+   MAX_CHUNKS chunks or once MAX_USEC microseconds have passed; zero
+   means no limit.  At least one chunk is freed if any is pending.
+   Return nonzero if chunks remain, so that the caller can resume later,
+   for instance from an idle hook.  */
+
+int
+obstack_release_step (struct obstack_release *r,
+                      size_t max_chunks, unsigned long max_usec)
 {
-  struct _obstack_chunk *lp;
-  _OBSTACK_SIZE_T nbytes = 0;
+  struct timespec start, now;
+  size_t n = 0;
 
-  for (lp = h->chunk; lp != 0; lp = lp->prev)
+  if (max_usec)
+    clock_gettime (CLOCK_MONOTONIC, &start);
+  while (r->chunk)
     {
-      nbytes += lp->limit - (char *) lp;
+      struct _obstack_chunk *lp = r->chunk;
+
+      r->owner->memory_used -= lp->limit - (char *) lp;
+      r->chunk = lp->prev;
+      if (!r->chunk && r->more)
+        {
+          r->chunk = r->more;
+          r->more = (struct _obstack_chunk *) r->chunk->tail;
+        }
+      if (r->use_extra_arg)
+        r->freefun.extra (r->extra_arg, lp);
+      else
+        r->freefun.plain (lp);
+
+      if (max_chunks && ++n >= max_chunks)
+        break;
+      if (max_usec)
+        {
+          clock_gettime (CLOCK_MONOTONIC, &now);
+          if ((unsigned long) ((now.tv_sec - start.tv_sec) * 1000000
+                               + (now.tv_nsec - start.tv_nsec) / 1000)
+              >= max_usec)
+            break;
+        }
     }
-  return nbytes;
+  return r->chunk != 0;
+}
+
+/* Return the total size of the chunks of H.  The macro reads the counter
+   directly; this is kept for callers compiled against it.  */
+
+_OBSTACK_SIZE_T
+_obstack_memory_used (struct obstack *h)
+{
+  return h->memory_used;
+}
+
+void
+_obstack_alloc_failed (struct obstack *h)
+{
+  if (h->failed_handler)
+    h->failed_handler (h);
+  (*obstack_alloc_failed_handler) ();
 }
 
 # ifndef _OBSTACK_NO_ERROR_HANDLER
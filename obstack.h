@@ -110,10 +110,12 @@
 // #endif
 
 #ifndef _OBSTACK_INTERFACE_VERSION
-# define _OBSTACK_INTERFACE_VERSION 2
+# define _OBSTACK_INTERFACE_VERSION 3
 #endif
 
 #include <stddef.h>             /* For size_t and ptrdiff_t.  */
+#include <stdint.h>             /* For uint64_t and uintmax_t.  */
+#include <stdio.h>              /* For FILE.  */
 #include <string.h>             /* For __GNU_LIBRARY__, and memcpy.  */
 
 #if __STDC_VERSION__ < 199901L || defined __HP_cc
@@ -124,7 +126,8 @@
 
 #if _OBSTACK_INTERFACE_VERSION == 1
 /* For binary compatibility with obstack version 1, which used "int"
-   and "long" for these two types.  */
+   and "long" for these two types.  Version 3 keeps the version 2 types
+   but appends fields to 'struct obstack'.  */
 # define _OBSTACK_SIZE_T unsigned int
 # define _CHUNK_SIZE_T unsigned long
 # define _OBSTACK_CAST(type, expr) ((type) (expr))
@@ -173,9 +176,21 @@ struct _obstack_chunk           /* Lives at front of each chunk. */
 {
   char *limit;                  /* 1 past end of this chunk */
   struct _obstack_chunk *prev;  /* address of prior chunk or NULL */
+  char *tail;                   /* start of space reused after this chunk
+                                   was abandoned, or NULL */
   char contents[__FLEXIBLE_ARRAY_MEMBER]; /* objects begin here */
 };
 
+/* Number of abandoned chunk tails an obstack remembers for reuse.  */
+#define _OBSTACK_NTAILS 4
+
+struct _obstack_tail            /* unused end of an abandoned chunk */
+{
+  char *base;                   /* first byte handed out from this tail */
+  char *next_free;              /* where the next tail object starts */
+  char *limit;                  /* end of the chunk, or 0 if slot unused */
+};
+
 struct obstack          /* control current object in current chunk */
 {
   _CHUNK_SIZE_T chunk_size;     /* preferred size to allocate chunks in */
@@ -208,15 +223,58 @@ struct obstack          /* control current object in current chunk */
                                       chunk contains a zero-length object.  This
                                       prevents freeing the chunk if we allocate
                                       a bigger chunk to replace it. */
-  unsigned alloc_failed : 1;      /* No longer used, as we now call the failed
-                                     handler on error, but retained for binary
-                                     compatibility.  */
+  unsigned alloc_failed : 1;      /* Set when one of the obstack_try_*
+                                     macros could not get more memory.  The
+                                     other macros call the failed handler
+                                     on error instead.  */
+  struct _obstack_tail tails[_OBSTACK_NTAILS]; /* Ends of older chunks left
+                                                  over by _obstack_newchunk,
+                                                  reused for small objects. */
+  _OBSTACK_SIZE_T tail_room;    /* Largest object one of the tails can take,
+                                   0 if none.  */
+
+  /* Called instead of 'obstack_alloc_failed_handler' when this obstack
+     cannot get more memory, or NULL to use the global handler.  It
+     should not return; if it does, the global handler is called.  */
+  void (*failed_handler) (struct obstack *);
+
+  _OBSTACK_SIZE_T memory_used;  /* Total size of the chunks in the chain,
+                                   and of those 'obstack_detach' took out
+                                   that are not freed yet.  */
+  _OBSTACK_SIZE_T soft_limit;   /* Call soft_limit_handler when a new chunk
+                                   takes memory_used above this; 0 for no
+                                   limit.  */
+  _OBSTACK_SIZE_T hard_limit;   /* Fail any new chunk that would take
+                                   memory_used above this; 0 for no limit. */
+  void (*soft_limit_handler) (struct obstack *);
+};
+
+/* Chunks taken out of an obstack by 'obstack_detach', waiting to be
+   freed a few at a time by 'obstack_release_step'.  Zero-initialize
+   before first use.  The chunks stay counted in the obstack's
+   'memory_used' until they are freed.  */
+
+struct obstack_release
+{
+  struct _obstack_chunk *chunk; /* next chunk to free, or NULL */
+  struct _obstack_chunk *more;  /* further detached chains, linked through
+                                   the 'tail' field of their newest chunk */
+  union
+  {
+    void (*plain) (void *);
+    void (*extra) (void *, void *);
+  } freefun;                    /* copied from the obstack */
+  void *extra_arg;
+  unsigned use_extra_arg : 1;
+  struct obstack *owner;        /* the obstack the chunks came from */
 };
 
 /* Declare the external functions we use; they are in obstack.c and obstack_printf.c.  */
 
 extern void _obstack_newchunk (struct obstack *, _OBSTACK_SIZE_T);
+extern int _obstack_try_newchunk (struct obstack *, _OBSTACK_SIZE_T);
 extern void _obstack_free (struct obstack *, void *);
+extern void *_obstack_tail_alloc (struct obstack *, _OBSTACK_SIZE_T);
 extern int _obstack_begin (struct obstack *,
                            _OBSTACK_SIZE_T, _OBSTACK_SIZE_T,
                            void *(*) (size_t), void (*) (void *));
@@ -226,12 +284,47 @@ extern int _obstack_begin_1 (struct obstack *,
                              void (*) (void *, void *), void *);
 extern _OBSTACK_SIZE_T _obstack_memory_used (struct obstack *)
   __attribute_pure__;
+extern void obstack_detach (struct obstack *, struct obstack_release *);
+extern int obstack_release_step (struct obstack_release *,
+                                 size_t, unsigned long);
 
 int
 obstack_printf (struct obstack *obs, const char *format, ...);
 int
 obstack_vprintf (struct obstack *obs, const char *format, va_list args);
 
+/* Open a stdio stream that appends to the current object of an obstack;
+   in obstack_stream.c.  */
+extern FILE *obstack_open_stream (struct obstack *);
+
+/* Append numbers as text to the current object; in obstack_num.c.  The
+   _pad variants insert zeros, after any minus sign, to make the text
+   at least WIDTH characters long.  obstack_grow_hex uses lowercase
+   digits and no "0x" prefix.  obstack_grow_double writes the shortest
+   text that reads back as the same double.  */
+
+extern void obstack_grow_u64 (struct obstack *, uint64_t);
+extern void obstack_grow_i64 (struct obstack *, int64_t);
+extern void obstack_grow_hex (struct obstack *, uint64_t);
+extern void obstack_grow_double (struct obstack *, double);
+extern void obstack_grow_u64_pad (struct obstack *, uint64_t, int);
+extern void obstack_grow_i64_pad (struct obstack *, int64_t, int);
+extern void obstack_grow_hex_pad (struct obstack *, uint64_t, int);
+
+/* Append binary data as hex or base64 text, or append the data that such
+   text encodes, to the current object; in obstack_base64.c.  Decoding
+   returns 0, or -1 if the text is malformed, in which case nothing is
+   appended.  */
+
+extern void obstack_grow_base16 (struct obstack *, const void *, size_t);
+extern void obstack_grow_base64 (struct obstack *, const void *, size_t);
+extern int obstack_grow_base16_decode (struct obstack *, const char *, size_t);
+extern int obstack_grow_base64_decode (struct obstack *, const char *, size_t);
+
+/* Digit conversion shared by obstack_printf.c and obstack_num.c.  */
+extern int _obstack_count_digits (uintmax_t, int);
+extern void _obstack_put_digits (char *, uintmax_t, int, int);
+
 /* Error handler called when 'obstack_chunk_alloc' failed to allocate
    more memory.  This can be set to a user defined function which
    should either abort gracefully or use longjump - but shouldn't
@@ -241,6 +334,11 @@ extern __attribute_noreturn__ void (*obstack_alloc_failed_handler) (void);
 /* Exit value used when 'print_and_abort' is used.  */
 extern int obstack_exit_failure;
 
+/* Report that obstack H could not get more memory, by calling its own
+   failed handler if it has one and 'obstack_alloc_failed_handler'
+   otherwise.  */
+extern __attribute_noreturn__ void _obstack_alloc_failed (struct obstack *);
+
 /* Pointer to beginning of object being allocated or to be allocated next.
    Note that this might not be the final address of the object
    because a new chunk might be needed to hold the final size.  */
@@ -286,11 +384,35 @@ extern int obstack_exit_failure;
 #define obstack_freefun(h, newfreefun)					      \
   ((void) ((h)->freefun.extra = (void *(*) (void *, void *)) (newfreefun)))
 
+/* Make obstack H call HANDLER, which must not return, when it cannot get
+   more memory.  A null HANDLER restores 'obstack_alloc_failed_handler'.
+   The obstack_try_* macros never call either handler; they return 0 or
+   a null pointer and leave the obstack unchanged instead.  */
+#define obstack_set_failed_handler(h, handler)				      \
+  ((void) ((h)->failed_handler = (handler)))
+
 #define obstack_1grow_fast(h, achar) ((void) (*((h)->next_free)++ = (achar)))
 
 #define obstack_blank_fast(h, n) ((void) ((h)->next_free += (n)))
 
-#define obstack_memory_used(h) _obstack_memory_used (h)
+#define obstack_memory_used(h) ((_OBSTACK_SIZE_T) (h)->memory_used)
+
+/* Limit the memory obstack H may hold in chunks.  Once a new chunk takes
+   the total above SOFT, HANDLER is called after the chunk is in place,
+   and again for every further chunk while the total stays above SOFT;
+   it may record back-pressure but must not allocate from or free H.  A
+   chunk that would take the total above HARD is not allocated, and the
+   allocation fails as if 'obstack_chunk_alloc' had returned NULL.  Zero
+   means no limit.  */
+
+#define obstack_set_limits(h, soft, hard, handler)			      \
+  ((void) ((h)->soft_limit = (soft), (h)->hard_limit = (hard),		      \
+           (h)->soft_limit_handler = (handler)))
+
+/* Nonzero if R still holds chunks that 'obstack_release_step' has not
+   freed yet.  */
+
+#define obstack_release_pending(r) ((r)->chunk != 0)
 
 #if defined __GNUC__ || defined __clang__
 # if !(defined __GNUC_MINOR__ && __GNUC__ * 1000 + __GNUC_MINOR__ >= 2008 \
@@ -401,23 +523,161 @@ extern int obstack_exit_failure;
          _obstack_newchunk (__o, __len);				      \
        obstack_blank_fast (__o, __len); })
 
+/* A small finished object is first offered to _obstack_tail_alloc,
+   which carves it from the unused end of an older chunk, so that the
+   current chunk keeps its room for larger objects.  When no tail can
+   take the object, this costs a single comparison over a plain bump.
+   Freeing such an object releases it and everything allocated after it
+   in the current chunk, just as for any other object.  Freeing back to
+   an object that was not carved from a tail leaves alone the tail space
+   taken after it, though: that space is reused only once the chunk
+   holding the tail is itself freed.  */
+
 # define obstack_alloc(OBSTACK, length)					      \
   __extension__								      \
     ({ struct obstack *__h = (OBSTACK);					      \
-       obstack_blank (__h, (length));					      \
-       obstack_finish (__h); })
+       _OBSTACK_SIZE_T __l = (length);					      \
+       void *__t = 0;							      \
+       if ((_OBSTACK_SIZE_T) (__l - 1) < __h->tail_room)		      \
+         __t = _obstack_tail_alloc (__h, __l);				      \
+       if (!__t)							      \
+         {								      \
+           obstack_blank (__h, __l);					      \
+           __t = obstack_finish (__h);					      \
+         }								      \
+       __t; })
 
 # define obstack_copy(OBSTACK, where, length)				      \
   __extension__								      \
     ({ struct obstack *__h = (OBSTACK);					      \
-       obstack_grow (__h, (where), (length));				      \
-       obstack_finish (__h); })
+       _OBSTACK_SIZE_T __l = (length);					      \
+       void *__t = 0;							      \
+       if ((_OBSTACK_SIZE_T) (__l - 1) < __h->tail_room)		      \
+         __t = _obstack_tail_alloc (__h, __l);				      \
+       if (__t)								      \
+         memcpy (__t, (where), __l);					      \
+       else								      \
+         {								      \
+           obstack_grow (__h, (where), __l);				      \
+           __t = obstack_finish (__h);					      \
+         }								      \
+       __t; })
 
 # define obstack_copy0(OBSTACK, where, length)				      \
   __extension__								      \
     ({ struct obstack *__h = (OBSTACK);					      \
-       obstack_grow0 (__h, (where), (length));				      \
-       obstack_finish (__h); })
+       _OBSTACK_SIZE_T __l = (length);					      \
+       void *__t = 0;							      \
+       if (__l < __h->tail_room)					      \
+         __t = _obstack_tail_alloc (__h, __l + 1);			      \
+       if (__t)								      \
+         {								      \
+           memcpy (__t, (where), __l);					      \
+           ((char *) __t)[__l] = 0;					      \
+         }								      \
+       else								      \
+         {								      \
+           obstack_grow0 (__h, (where), __l);				      \
+           __t = obstack_finish (__h);					      \
+         }								      \
+       __t; })
+
+/* The obstack_try_* variants behave like the macros above when memory
+   is available, and otherwise return 0 (or a null pointer for those
+   that return an object) without changing the obstack.  */
+
+# define obstack_try_make_room(OBSTACK, length)			      \
+  __extension__								      \
+    ({ struct obstack *__o = (OBSTACK);					      \
+       _OBSTACK_SIZE_T __len = (length);				      \
+       (obstack_room (__o) >= __len					      \
+        || _obstack_try_newchunk (__o, __len)); })
+
+# define obstack_try_grow(OBSTACK, where, length)			      \
+  __extension__								      \
+    ({ struct obstack *__o = (OBSTACK);					      \
+       _OBSTACK_SIZE_T __len = (length);				      \
+       int __ok = (obstack_room (__o) >= __len				      \
+                   || _obstack_try_newchunk (__o, __len));		      \
+       if (__ok)							      \
+         {								      \
+           memcpy (__o->next_free, where, __len);			      \
+           __o->next_free += __len;					      \
+         }								      \
+       __ok; })
+
+# define obstack_try_grow0(OBSTACK, where, length)			      \
+  __extension__								      \
+    ({ struct obstack *__o = (OBSTACK);					      \
+       _OBSTACK_SIZE_T __len = (length);				      \
+       int __ok = (obstack_room (__o) >= __len + 1			      \
+                   || _obstack_try_newchunk (__o, __len + 1));		      \
+       if (__ok)							      \
+         {								      \
+           memcpy (__o->next_free, where, __len);			      \
+           __o->next_free += __len;					      \
+           *(__o->next_free)++ = 0;					      \
+         }								      \
+       __ok; })
+
+# define obstack_try_1grow(OBSTACK, datum)				      \
+  __extension__								      \
+    ({ struct obstack *__o = (OBSTACK);					      \
+       int __ok = (obstack_room (__o) >= 1				      \
+                   || _obstack_try_newchunk (__o, 1));			      \
+       if (__ok)							      \
+         obstack_1grow_fast (__o, datum);				      \
+       __ok; })
+
+# define obstack_try_blank(OBSTACK, length)				      \
+  __extension__								      \
+    ({ struct obstack *__o = (OBSTACK);					      \
+       _OBSTACK_SIZE_T __len = (length);				      \
+       int __ok = (obstack_room (__o) >= __len				      \
+                   || _obstack_try_newchunk (__o, __len));		      \
+       if (__ok)							      \
+         obstack_blank_fast (__o, __len);				      \
+       __ok; })
+
+# define obstack_try_alloc(OBSTACK, length)				      \
+  __extension__								      \
+    ({ struct obstack *__h = (OBSTACK);					      \
+       _OBSTACK_SIZE_T __l = (length);					      \
+       void *__t = 0;							      \
+       if ((_OBSTACK_SIZE_T) (__l - 1) < __h->tail_room)		      \
+         __t = _obstack_tail_alloc (__h, __l);				      \
+       if (!__t && obstack_try_blank (__h, __l))			      \
+         __t = obstack_finish (__h);					      \
+       __t; })
+
+# define obstack_try_copy(OBSTACK, where, length)			      \
+  __extension__								      \
+    ({ struct obstack *__h = (OBSTACK);					      \
+       _OBSTACK_SIZE_T __l = (length);					      \
+       void *__t = 0;							      \
+       if ((_OBSTACK_SIZE_T) (__l - 1) < __h->tail_room)		      \
+         __t = _obstack_tail_alloc (__h, __l);				      \
+       if (__t)								      \
+         memcpy (__t, (where), __l);					      \
+       else if (obstack_try_grow (__h, (where), __l))			      \
+         __t = obstack_finish (__h);					      \
+       __t; })
+
+# define obstack_try_copy0(OBSTACK, where, length)			      \
+  __extension__								      \
+    ({ struct obstack *__h = (OBSTACK);					      \
+       _OBSTACK_SIZE_T __l = (length);					      \
+       void *__t = 0;							      \
+       if (__l < __h->tail_room)					      \
+         __t = _obstack_tail_alloc (__h, __l + 1);			      \
+       if (__t)								      \
+         {								      \
+           memcpy (__t, (where), __l);					      \
+           ((char *) __t)[__l] = 0;					      \
+         }								      \
+       else if (obstack_try_grow0 (__h, (where), __l))			      \
+         __t = obstack_finish (__h);					      \
+       __t; })
 
 /* The local variable is named __o1 to avoid a shadowed variable
    warning when invoked from other obstack macros, typically obstack_free.  */
@@ -518,13 +778,76 @@ extern int obstack_exit_failure;
    obstack_blank_fast (h, (h)->temp.i))
 
 # define obstack_alloc(h, length)					      \
-  (obstack_blank ((h), (length)), obstack_finish ((h)))
+  (((_OBSTACK_SIZE_T) ((length) - 1) < (h)->tail_room			      \
+    && ((h)->temp.p = _obstack_tail_alloc ((h), (length))) != 0)	      \
+   ? (h)->temp.p							      \
+   : (obstack_blank ((h), (length)), obstack_finish ((h))))
 
 # define obstack_copy(h, where, length)					      \
-  (obstack_grow ((h), (where), (length)), obstack_finish ((h)))
+  (((_OBSTACK_SIZE_T) ((length) - 1) < (h)->tail_room			      \
+    && ((h)->temp.p = _obstack_tail_alloc ((h), (length))) != 0)	      \
+   ? memcpy ((h)->temp.p, (where), (length))				      \
+   : (obstack_grow ((h), (where), (length)), obstack_finish ((h))))
 
 # define obstack_copy0(h, where, length)				      \
-  (obstack_grow0 ((h), (where), (length)), obstack_finish ((h)))
+  (((_OBSTACK_SIZE_T) (length) < (h)->tail_room				      \
+    && ((h)->temp.p = _obstack_tail_alloc ((h), (length) + 1)) != 0)	      \
+   ? (((char *) memcpy ((h)->temp.p, (where), (length)))[length] = 0,	      \
+      (h)->temp.p)							      \
+   : (obstack_grow0 ((h), (where), (length)), obstack_finish ((h))))
+
+# define obstack_try_make_room(h, length)				      \
+  ((h)->temp.i = (length),						      \
+   (obstack_room (h) >= (h)->temp.i					      \
+    || _obstack_try_newchunk ((h), (h)->temp.i)))
+
+# define obstack_try_grow(h, where, length)				      \
+  ((h)->temp.i = (length),						      \
+   ((obstack_room (h) >= (h)->temp.i					      \
+     || _obstack_try_newchunk ((h), (h)->temp.i))			      \
+    ? (memcpy ((h)->next_free, where, (h)->temp.i),			      \
+       (h)->next_free += (h)->temp.i, 1)				      \
+    : 0))
+
+# define obstack_try_grow0(h, where, length)				      \
+  ((h)->temp.i = (length),						      \
+   ((obstack_room (h) >= (h)->temp.i + 1				      \
+     || _obstack_try_newchunk ((h), (h)->temp.i + 1))			      \
+    ? (memcpy ((h)->next_free, where, (h)->temp.i),			      \
+       (h)->next_free += (h)->temp.i,					      \
+       *((h)->next_free)++ = 0, 1)					      \
+    : 0))
+
+# define obstack_try_1grow(h, datum)					      \
+  ((obstack_room (h) >= 1 || _obstack_try_newchunk ((h), 1))		      \
+   ? (obstack_1grow_fast (h, datum), 1) : 0)
+
+# define obstack_try_blank(h, length)					      \
+  ((h)->temp.i = (length),						      \
+   ((obstack_room (h) >= (h)->temp.i					      \
+     || _obstack_try_newchunk ((h), (h)->temp.i))			      \
+    ? (obstack_blank_fast (h, (h)->temp.i), 1) : 0))
+
+# define obstack_try_alloc(h, length)					      \
+  (((_OBSTACK_SIZE_T) ((length) - 1) < (h)->tail_room			      \
+    && ((h)->temp.p = _obstack_tail_alloc ((h), (length))) != 0)	      \
+   ? (h)->temp.p							      \
+   : obstack_try_blank ((h), (length)) ? obstack_finish ((h)) : (void *) 0)
+
+# define obstack_try_copy(h, where, length)				      \
+  (((_OBSTACK_SIZE_T) ((length) - 1) < (h)->tail_room			      \
+    && ((h)->temp.p = _obstack_tail_alloc ((h), (length))) != 0)	      \
+   ? memcpy ((h)->temp.p, (where), (length))				      \
+   : obstack_try_grow ((h), (where), (length))				      \
+   ? obstack_finish ((h)) : (void *) 0)
+
+# define obstack_try_copy0(h, where, length)				      \
+  (((_OBSTACK_SIZE_T) (length) < (h)->tail_room				      \
+    && ((h)->temp.p = _obstack_tail_alloc ((h), (length) + 1)) != 0)	      \
+   ? (((char *) memcpy ((h)->temp.p, (where), (length)))[length] = 0,	      \
+      (h)->temp.p)							      \
+   : obstack_try_grow0 ((h), (where), (length))				      \
+   ? obstack_finish ((h)) : (void *) 0)
 
 # define obstack_finish(h)						      \
   (((h)->next_free == (h)->object_base					      \
@@ -0,0 +1,412 @@
+/* obstack.hh - C++ owner of an obstack
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   An Obstack owns a struct obstack whose chunks come from malloc, and
+   frees them all when it is destroyed:
+
+        gnulib::Obstack ob;
+        Node *n = ob.make<Node> (key, value);
+        {
+          gnulib::Obstack::Checkpoint cp (ob);
+          std::string *tmp = ob.make<std::string> ("scratch");
+          ...
+        }                       -- tmp is destroyed and its space reused
+
+   make<T> constructs a T in storage aligned for it.  Objects of types
+   with a nontrivial destructor are recorded, at the cost of a small
+   record in the obstack, and destroyed in reverse order when the
+   Obstack is destroyed or a Checkpoint taken before them goes out of
+   scope.  Objects of trivially destructible types cost nothing beyond
+   their storage, and every member function is an inline use of the
+   obstack.h macros.
+
+   Checkpoints must be destroyed in the reverse order of their creation.
+   Allocation failure throws std::bad_alloc.  Obstacks can be moved but
+   not copied; get () gives the struct obstack for use with the C
+   interface.
+
+   BasicObstack<Align, ChunkSize> is a leaner owner for hot paths.  Its
+   alignment and chunk size are constants, so that allocating, growing
+   by a fixed length and finishing an object compile to a bounds check,
+   a fixed-size copy and constant-mask arithmetic, with a call only when
+   the chunk is full.  It holds nothing but a struct obstack set up with
+   those constants, so get () can be passed to any of the C functions
+   and macros, and objects can be built with both.  It does not track
+   destructors; make<T> takes trivially destructible types only.  */
+
+#ifndef _OBSTACK_HH
+#define _OBSTACK_HH 1
+
+#include "obstack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace gnulib
+{
+
+class Obstack
+{
+  /* Record of an object to destroy.  */
+  struct Cleanup
+  {
+    void (*destroy) (void *);
+    void *object;
+    Cleanup *prev;
+  };
+
+public:
+  class Checkpoint;
+
+  /* Use chunks of CHUNK_SIZE bytes and align objects to ALIGNMENT; zero
+     for either means the obstack default.  */
+  explicit Obstack (std::size_t chunk_size = 0, std::size_t alignment = 0)
+  {
+    obstack_specify_allocation (&h_, chunk_size, alignment,
+                                std::malloc, std::free);
+  }
+
+  Obstack (Obstack &&other) noexcept
+    : h_ (other.h_), cleanups_ (other.cleanups_)
+  {
+    other.h_.chunk = nullptr;
+    other.cleanups_ = nullptr;
+  }
+
+  Obstack &
+  operator= (Obstack &&other) noexcept
+  {
+    if (this != &other)
+      {
+        clear ();
+        h_ = other.h_;
+        cleanups_ = other.cleanups_;
+        other.h_.chunk = nullptr;
+        other.cleanups_ = nullptr;
+      }
+    return *this;
+  }
+
+  Obstack (const Obstack &) = delete;
+  Obstack &operator= (const Obstack &) = delete;
+
+  ~Obstack () { clear (); }
+
+  struct obstack *get () noexcept { return &h_; }
+
+  /* Return N bytes aligned as the obstack aligns objects.  */
+  void *
+  alloc (std::size_t n)
+  {
+    void *p = obstack_try_alloc (&h_, n);
+    if (!p)
+      throw std::bad_alloc ();
+    return p;
+  }
+
+  /* Return N bytes aligned to ALIGN, a power of 2.  */
+  void *
+  alloc (std::size_t n, std::size_t align)
+  {
+    void *base;
+    return carve (n, align, &base);
+  }
+
+  template <typename T, typename... Args>
+  T *
+  make (Args &&...args)
+  {
+    void *base, *p;
+
+    if constexpr (std::is_trivially_destructible_v<T>)
+      {
+        p = carve (sizeof (T), alignof (T), &base);
+        try
+          {
+            return ::new (p) T (std::forward<Args> (args)...);
+          }
+        catch (...)
+          {
+            obstack_free (&h_, base);
+            throw;
+          }
+      }
+    else
+      {
+        /* The record comes first, so that freeing it frees both.  */
+        Cleanup *c = static_cast<Cleanup *> (alloc (sizeof (Cleanup)));
+        T *t;
+
+        try
+          {
+            p = carve (sizeof (T), alignof (T), &base);
+            t = ::new (p) T (std::forward<Args> (args)...);
+          }
+        catch (...)
+          {
+            obstack_free (&h_, c);
+            throw;
+          }
+        c->destroy = [] (void *o) { static_cast<T *> (o)->~T (); };
+        c->object = t;
+        c->prev = cleanups_;
+        cleanups_ = c;
+        return t;
+      }
+  }
+
+  std::size_t memory_used () noexcept { return obstack_memory_used (&h_); }
+
+private:
+  /* Return N bytes aligned to ALIGN, and set *BASE to the object they
+     are part of.  */
+  void *
+  carve (std::size_t n, std::size_t align, void **base)
+  {
+    std::size_t mask = obstack_alignment_mask (&h_);
+    std::size_t slack;
+
+    if (align <= mask + 1)
+      return *base = alloc (n);
+    slack = align - (mask + 1);
+    if (n > (_OBSTACK_SIZE_T) -1 - slack)
+      throw std::bad_alloc ();
+    *base = alloc (n + slack);
+    return (void *) (((std::uintptr_t) *base + align - 1)
+                     & ~(std::uintptr_t) (align - 1));
+  }
+
+  /* Destroy the recorded objects back to STOP.  */
+  void
+  unwind (Cleanup *stop) noexcept
+  {
+    while (cleanups_ != stop)
+      {
+        Cleanup *c = cleanups_;
+        cleanups_ = c->prev;
+        c->destroy (c->object);
+      }
+  }
+
+  void
+  clear () noexcept
+  {
+    if (h_.chunk)
+      {
+        unwind (nullptr);
+        obstack_free (&h_, nullptr);
+        h_.chunk = nullptr;
+      }
+  }
+
+  struct obstack h_;
+  Cleanup *cleanups_ = nullptr;
+};
+
+/* Rewinds its Obstack, destroying what was made since, when it goes out
+   of scope.  */
+
+class Obstack::Checkpoint
+{
+public:
+  explicit Checkpoint (Obstack &ob)
+    : ob_ (ob), mark_ (obstack_finish (&ob.h_)), cleanups_ (ob.cleanups_)
+  {
+  }
+
+  Checkpoint (const Checkpoint &) = delete;
+  Checkpoint &operator= (const Checkpoint &) = delete;
+
+  ~Checkpoint ()
+  {
+    ob_.unwind (cleanups_);
+    obstack_free (&ob_.h_, mark_);
+  }
+
+private:
+  Obstack &ob_;
+  void *mark_;
+  Cleanup *cleanups_;
+};
+
+template <std::size_t Align = alignof (std::max_align_t),
+          std::size_t ChunkSize = 0>
+class BasicObstack
+{
+  static_assert (Align > 0 && (Align & (Align - 1)) == 0,
+                 "the alignment must be a power of 2");
+
+public:
+  static constexpr std::size_t alignment = Align;
+
+  BasicObstack ()
+  {
+    obstack_specify_allocation (&h_, ChunkSize, Align, std::malloc, std::free);
+  }
+
+  BasicObstack (BasicObstack &&other) noexcept : h_ (other.h_)
+  {
+    other.h_.chunk = nullptr;
+  }
+
+  BasicObstack &
+  operator= (BasicObstack &&other) noexcept
+  {
+    if (this != &other)
+      {
+        clear ();
+        h_ = other.h_;
+        other.h_.chunk = nullptr;
+      }
+    return *this;
+  }
+
+  BasicObstack (const BasicObstack &) = delete;
+  BasicObstack &operator= (const BasicObstack &) = delete;
+
+  ~BasicObstack () { clear (); }
+
+  struct obstack *get () noexcept { return &h_; }
+
+  /* As obstack_alloc: add N bytes to the current object and finish it.  */
+  void *
+  alloc (std::size_t n)
+  {
+    if (__builtin_expect (n <= (std::size_t) (h_.chunk_limit - h_.next_free), 1))
+      {
+        void *p = h_.object_base;
+        char *end;
+
+        /* For a constant N, this test goes away unless N is zero.  */
+        if (n == 0 && h_.next_free == p)
+          h_.maybe_empty_object = 1;
+        end = align_up (h_.next_free + n);
+        h_.next_free = h_.object_base = end <= h_.chunk_limit ? end : h_.chunk_limit;
+        return p;
+      }
+    return alloc_slow (n);
+  }
+
+  template <std::size_t N>
+  void *
+  alloc ()
+  {
+    return alloc (N);
+  }
+
+  /* As obstack_grow.  */
+  void
+  grow (const void *data, std::size_t n)
+  {
+    if (__builtin_expect (n > (std::size_t) (h_.chunk_limit - h_.next_free), 0))
+      make_room_slow (n);
+    std::memcpy (h_.next_free, data, n);
+    h_.next_free += n;
+  }
+
+  template <std::size_t N>
+  void
+  grow (const void *data)
+  {
+    grow (data, N);
+  }
+
+  void
+  grow1 (char c)
+  {
+    if (__builtin_expect (h_.next_free == h_.chunk_limit, 0))
+      make_room_slow (1);
+    *h_.next_free++ = c;
+  }
+
+  std::size_t object_size () const noexcept
+  {
+    return h_.next_free - h_.object_base;
+  }
+
+  /* As obstack_finish.  */
+  void *
+  finish () noexcept
+  {
+    void *p = h_.object_base;
+    char *end;
+
+    if (h_.next_free == p)
+      h_.maybe_empty_object = 1;
+    end = align_up (h_.next_free);
+    h_.next_free = h_.object_base = end <= h_.chunk_limit ? end : h_.chunk_limit;
+    return p;
+  }
+
+  void free (void *obj) noexcept { obstack_free (&h_, obj); }
+
+  template <typename T, typename... Args>
+  T *
+  make (Args &&...args)
+  {
+    static_assert (alignof (T) <= Align, "the type needs stricter alignment");
+    static_assert (std::is_trivially_destructible_v<T>,
+                   "the type has a destructor to run");
+    return ::new (alloc (sizeof (T))) T (std::forward<Args> (args)...);
+  }
+
+private:
+  static char *
+  align_up (char *p) noexcept
+  {
+    return (char *) (((std::uintptr_t) p + Align - 1)
+                     & ~(std::uintptr_t) (Align - 1));
+  }
+
+  __attribute__ ((__noinline__)) void *
+  alloc_slow (std::size_t n)
+  {
+    void *p = obstack_try_alloc (&h_, n);
+    if (!p)
+      throw std::bad_alloc ();
+    return p;
+  }
+
+  __attribute__ ((__noinline__)) void
+  make_room_slow (std::size_t n)
+  {
+    if (!obstack_try_make_room (&h_, n))
+      throw std::bad_alloc ();
+  }
+
+  void
+  clear () noexcept
+  {
+    if (h_.chunk)
+      {
+        obstack_free (&h_, nullptr);
+        h_.chunk = nullptr;
+      }
+  }
+
+  struct obstack h_;
+};
+
+}       /* namespace gnulib */
+
+#endif /* _OBSTACK_HH */
@@ -0,0 +1,127 @@
+/* obstack_allocator.hh - standard C++ allocator over an obstack
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   ObstackAllocator<T> meets the Allocator requirements of the standard
+   library, for code that takes an allocator type rather than a pmr
+   memory resource:
+
+        using Alloc = gnulib::ObstackAllocator<std::pair<const int, int>>;
+        std::map<int, int, std::less<int>, Alloc> m (Alloc (&ob));
+
+   Nodes are then carved out of the obstack one after another, with no
+   call to malloc for each.  As with ObstackResource, deallocation only
+   gives back the last object in the obstack, the obstack must outlive
+   the containers using it, no object may be growing in it meanwhile, and
+   failure throws std::bad_alloc.
+
+   Two allocators are equal if they use the same obstack.  They propagate
+   with the containers that hold them, so that moving or swapping
+   containers never needs to copy elements between obstacks.  */
+
+#ifndef _OBSTACK_ALLOCATOR_HH
+#define _OBSTACK_ALLOCATOR_HH 1
+
+#include "obstack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace gnulib
+{
+
+template <typename T>
+class ObstackAllocator
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = ObstackAllocator<U>;
+  };
+
+  explicit ObstackAllocator (struct obstack *h) noexcept : h_ (h) {}
+
+  template <typename U>
+  ObstackAllocator (const ObstackAllocator<U> &other) noexcept
+    : h_ (other.obstack ())
+  {
+  }
+
+  struct obstack *obstack () const noexcept { return h_; }
+
+  T *
+  allocate (std::size_t n)
+  {
+    std::size_t mask = obstack_alignment_mask (h_);
+    std::size_t slack = alignof (T) > mask + 1 ? alignof (T) - (mask + 1) : 0;
+    void *p;
+
+    if (n > ((_OBSTACK_SIZE_T) -1 - slack) / sizeof (T))
+      throw std::bad_array_new_length ();
+    if (!(p = obstack_try_alloc (h_, n * sizeof (T) + slack)))
+      throw std::bad_alloc ();
+    if (slack)
+      p = (void *) (((std::uintptr_t) p + alignof (T) - 1)
+                    & ~(std::uintptr_t) (alignof (T) - 1));
+    return static_cast<T *> (p);
+  }
+
+  void
+  deallocate (T *p, std::size_t n) noexcept
+  {
+    std::uintptr_t mask = obstack_alignment_mask (h_);
+
+    /* Rewind only to the last object, and never to an over-aligned one,
+       which may not start where its object does.  */
+    if (alignof (T) <= mask + 1 && obstack_object_size (h_) == 0
+        && (void *) (((std::uintptr_t) (p + n) + mask) & ~mask)
+           == obstack_next_free (h_))
+      obstack_free (h_, p);
+  }
+
+private:
+  struct obstack *h_;
+};
+
+template <typename T, typename U>
+inline bool
+operator== (const ObstackAllocator<T> &a, const ObstackAllocator<U> &b) noexcept
+{
+  return a.obstack () == b.obstack ();
+}
+
+template <typename T, typename U>
+inline bool
+operator!= (const ObstackAllocator<T> &a, const ObstackAllocator<U> &b) noexcept
+{
+  return !(a == b);
+}
+
+}       /* namespace gnulib */
+
+#endif /* _OBSTACK_ALLOCATOR_HH */
@@ -0,0 +1,564 @@
+/* obstack_base64.c - append hex and base64 encodings to obstacks
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification.  */
+#include "obstack.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "simd.h"
+
+#if defined __x86_64__ || defined __i386__
+# include <immintrin.h>
+#endif
+
+/* Each function makes room once for exactly the bytes it appends and
+   writes them in place.  The bulk of the input goes through a vector
+   kernel chosen for the CPU on first use; a kernel returns how many
+   input bytes it handled, and the scalar code does the rest.  A decoding
+   kernel also stops short of any block with an invalid character, so
+   that the scalar code is the one to find it.  Kernels may store up to
+   a vector's width past the bytes they handle, but only where the bytes
+   that follow will be written over.  */
+
+typedef size_t (*kernel_fn) (char *, const unsigned char *, size_t);
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static const char b64_digits[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Values of the ASCII characters as digits, or -1.  */
+
+static const signed char hex_values[128] =
+{
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static const signed char b64_values[128] =
+{
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+  -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+  -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+};
+
+#define VALUE(table, c) ((c) < 128 ? (table)[c] : -1)
+
+static size_t
+no_kernel (char *dst, const unsigned char *src, size_t n)
+{
+  (void) dst, (void) src, (void) n;
+  return 0;
+}
+
+#if defined __x86_64__ || defined __i386__
+
+/* Hex: each byte becomes its high and low nibble looked up in a table.  */
+
+__attribute__ ((__target__ ("ssse3"))) static size_t
+base16_encode_ssse3 (char *dst, const unsigned char *src, size_t n)
+{
+  const __m128i digits = _mm_loadu_si128 ((const __m128i *) hex_digits);
+  const __m128i nibble = _mm_set1_epi8 (0x0F);
+  size_t i;
+
+  for (i = 0; n - i >= 16; i += 16, dst += 32)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (src + i));
+      __m128i hi = _mm_shuffle_epi8 (digits, _mm_and_si128 (_mm_srli_epi16 (v, 4),
+                                                            nibble));
+      __m128i lo = _mm_shuffle_epi8 (digits, _mm_and_si128 (v, nibble));
+
+      _mm_storeu_si128 ((__m128i *) dst, _mm_unpacklo_epi8 (hi, lo));
+      _mm_storeu_si128 ((__m128i *) (dst + 16), _mm_unpackhi_epi8 (hi, lo));
+    }
+  return i;
+}
+
+__attribute__ ((__target__ ("avx2"))) static size_t
+base16_encode_avx2 (char *dst, const unsigned char *src, size_t n)
+{
+  const __m256i digits
+    = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) hex_digits));
+  const __m256i nibble = _mm256_set1_epi8 (0x0F);
+  size_t i;
+
+  for (i = 0; n - i >= 32; i += 32, dst += 64)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (src + i));
+      __m256i hi = _mm256_shuffle_epi8 (digits,
+                                        _mm256_and_si256 (_mm256_srli_epi16 (v, 4),
+                                                          nibble));
+      __m256i lo = _mm256_shuffle_epi8 (digits, _mm256_and_si256 (v, nibble));
+      /* The unpacks work within each 128-bit lane.  */
+      __m256i a = _mm256_unpacklo_epi8 (hi, lo);
+      __m256i b = _mm256_unpackhi_epi8 (hi, lo);
+
+      _mm256_storeu_si256 ((__m256i *) dst, _mm256_permute2x128_si256 (a, b, 0x20));
+      _mm256_storeu_si256 ((__m256i *) (dst + 32),
+                           _mm256_permute2x128_si256 (a, b, 0x31));
+    }
+  return i + base16_encode_ssse3 (dst, src + i, n - i);
+}
+
+/* Return the nibble values of the hex digits in V, and set *BAD to a
+   mask of the bytes that are not hex digits.  */
+
+__attribute__ ((__target__ ("ssse3"))) static __m128i
+hex_values_ssse3 (__m128i v, unsigned *bad)
+{
+  __m128i d = _mm_sub_epi8 (v, _mm_set1_epi8 ('0'));
+  __m128i l = _mm_sub_epi8 (_mm_or_si128 (v, _mm_set1_epi8 (0x20)),
+                            _mm_set1_epi8 ('a'));
+  __m128i is_digit = _mm_cmpeq_epi8 (_mm_min_epu8 (d, _mm_set1_epi8 (9)), d);
+  __m128i is_letter = _mm_cmpeq_epi8 (_mm_min_epu8 (l, _mm_set1_epi8 (5)), l);
+
+  *bad = ~_mm_movemask_epi8 (_mm_or_si128 (is_digit, is_letter)) & 0xFFFF;
+  return _mm_or_si128 (_mm_and_si128 (is_digit, d),
+                       _mm_and_si128 (is_letter,
+                                      _mm_add_epi8 (l, _mm_set1_epi8 (10))));
+}
+
+__attribute__ ((__target__ ("ssse3"))) static size_t
+base16_decode_ssse3 (char *dst, const unsigned char *src, size_t n)
+{
+  /* Each pair of nibbles becomes 16 * high + low.  */
+  const __m128i weights = _mm_set1_epi16 (0x0110);
+  size_t i;
+
+  for (i = 0; n - i >= 32; i += 32, dst += 16)
+    {
+      unsigned bad_a, bad_b;
+      __m128i a = hex_values_ssse3 (_mm_loadu_si128 ((const __m128i *) (src + i)),
+                                    &bad_a);
+      __m128i b = hex_values_ssse3 (_mm_loadu_si128 ((const __m128i *) (src + i + 16)),
+                                    &bad_b);
+
+      if (bad_a | bad_b)
+        break;
+      _mm_storeu_si128 ((__m128i *) dst,
+                        _mm_packus_epi16 (_mm_maddubs_epi16 (a, weights),
+                                          _mm_maddubs_epi16 (b, weights)));
+    }
+  return i;
+}
+
+__attribute__ ((__target__ ("avx2"))) static __m256i
+hex_values_avx2 (__m256i v, unsigned *bad)
+{
+  __m256i d = _mm256_sub_epi8 (v, _mm256_set1_epi8 ('0'));
+  __m256i l = _mm256_sub_epi8 (_mm256_or_si256 (v, _mm256_set1_epi8 (0x20)),
+                               _mm256_set1_epi8 ('a'));
+  __m256i is_digit = _mm256_cmpeq_epi8 (_mm256_min_epu8 (d, _mm256_set1_epi8 (9)), d);
+  __m256i is_letter = _mm256_cmpeq_epi8 (_mm256_min_epu8 (l, _mm256_set1_epi8 (5)), l);
+
+  *bad = ~_mm256_movemask_epi8 (_mm256_or_si256 (is_digit, is_letter));
+  return _mm256_or_si256 (_mm256_and_si256 (is_digit, d),
+                          _mm256_and_si256 (is_letter,
+                                            _mm256_add_epi8 (l, _mm256_set1_epi8 (10))));
+}
+
+__attribute__ ((__target__ ("avx2"))) static size_t
+base16_decode_avx2 (char *dst, const unsigned char *src, size_t n)
+{
+  const __m256i weights = _mm256_set1_epi16 (0x0110);
+  size_t i;
+
+  for (i = 0; n - i >= 64; i += 64, dst += 32)
+    {
+      unsigned bad_a, bad_b;
+      __m256i a = hex_values_avx2 (_mm256_loadu_si256 ((const __m256i *) (src + i)),
+                                   &bad_a);
+      __m256i b = hex_values_avx2 (_mm256_loadu_si256 ((const __m256i *) (src + i + 32)),
+                                   &bad_b);
+      __m256i packed;
+
+      if (bad_a | bad_b)
+        break;
+      /* The pack works within each lane; put the quarters back in order.  */
+      packed = _mm256_packus_epi16 (_mm256_maddubs_epi16 (a, weights),
+                                    _mm256_maddubs_epi16 (b, weights));
+      _mm256_storeu_si256 ((__m256i *) dst, _mm256_permute4x64_epi64 (packed, 0xD8));
+    }
+  return i + base16_decode_ssse3 (dst, src + i, n - i);
+}
+
+/* Base64, after Wojciech Muła's and Daniel Lemire's methods: spread each
+   3 bytes over 4 bytes of 6 bits, then add to each the offset of its
+   range of the alphabet.  */
+
+__attribute__ ((__target__ ("ssse3"))) static __m128i
+b64_encode_block_ssse3 (__m128i in)
+{
+  const __m128i offsets = _mm_setr_epi8 ('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                         '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                         '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                         '/' - 63, 'A', 0, 0);
+  __m128i t0, t1, t2, t3, sextets, range;
+
+  in = _mm_shuffle_epi8 (in, _mm_set_epi8 (10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1));
+  t0 = _mm_and_si128 (in, _mm_set1_epi32 (0x0FC0FC00));
+  t1 = _mm_mulhi_epu16 (t0, _mm_set1_epi32 (0x04000040));
+  t2 = _mm_and_si128 (in, _mm_set1_epi32 (0x003F03F0));
+  t3 = _mm_mullo_epi16 (t2, _mm_set1_epi32 (0x01000010));
+  sextets = _mm_or_si128 (t1, t3);
+
+  /* 13 for A-Z, 0 for a-z, 1-10 for 0-9, 11 for '+', 12 for '/'.  */
+  range = _mm_subs_epu8 (sextets, _mm_set1_epi8 (51));
+  range = _mm_or_si128 (range,
+                        _mm_and_si128 (_mm_cmpgt_epi8 (_mm_set1_epi8 (26), sextets),
+                                       _mm_set1_epi8 (13)));
+  return _mm_add_epi8 (sextets, _mm_shuffle_epi8 (offsets, range));
+}
+
+__attribute__ ((__target__ ("ssse3"))) static size_t
+base64_encode_ssse3 (char *dst, const unsigned char *src, size_t n)
+{
+  size_t i;
+
+  /* Each block reads 16 bytes and uses 12 of them.  */
+  for (i = 0; n - i >= 16; i += 12, dst += 16)
+    _mm_storeu_si128 ((__m128i *) dst,
+                      b64_encode_block_ssse3 (_mm_loadu_si128 ((const __m128i *)
+                                                               (src + i))));
+  return i;
+}
+
+__attribute__ ((__target__ ("avx2"))) static __m256i
+b64_encode_block_avx2 (__m256i in)
+{
+  const __m256i offsets
+    = _mm256_setr_epi8 ('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                        '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                        '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  __m256i t0, t1, t2, t3, sextets, range;
+
+  in = _mm256_shuffle_epi8 (in, _mm256_set_epi8 (10, 11, 9, 10, 7, 8, 6, 7,
+                                                 4, 5, 3, 4, 1, 2, 0, 1,
+                                                 10, 11, 9, 10, 7, 8, 6, 7,
+                                                 4, 5, 3, 4, 1, 2, 0, 1));
+  t0 = _mm256_and_si256 (in, _mm256_set1_epi32 (0x0FC0FC00));
+  t1 = _mm256_mulhi_epu16 (t0, _mm256_set1_epi32 (0x04000040));
+  t2 = _mm256_and_si256 (in, _mm256_set1_epi32 (0x003F03F0));
+  t3 = _mm256_mullo_epi16 (t2, _mm256_set1_epi32 (0x01000010));
+  sextets = _mm256_or_si256 (t1, t3);
+
+  range = _mm256_subs_epu8 (sextets, _mm256_set1_epi8 (51));
+  range = _mm256_or_si256 (range,
+                           _mm256_and_si256 (_mm256_cmpgt_epi8 (_mm256_set1_epi8 (26),
+                                                                sextets),
+                                             _mm256_set1_epi8 (13)));
+  return _mm256_add_epi8 (sextets, _mm256_shuffle_epi8 (offsets, range));
+}
+
+__attribute__ ((__target__ ("avx2"))) static size_t
+base64_encode_avx2 (char *dst, const unsigned char *src, size_t n)
+{
+  size_t i;
+
+  /* Each lane takes 12 of the 16 bytes loaded into it.  */
+  for (i = 0; n - i >= 28; i += 24, dst += 32)
+    {
+      __m128i lo = _mm_loadu_si128 ((const __m128i *) (src + i));
+      __m128i hi = _mm_loadu_si128 ((const __m128i *) (src + i + 12));
+
+      _mm256_storeu_si256 ((__m256i *) dst,
+                           b64_encode_block_avx2 (_mm256_inserti128_si256
+                                                  (_mm256_castsi128_si256 (lo),
+                                                   hi, 1)));
+    }
+  return i + base64_encode_ssse3 (dst, src + i, n - i);
+}
+
+/* Decoding classifies each character by its two nibbles: LUT_LO and
+   LUT_HI have no bit in common for exactly the alphabet.  The high
+   nibble, adjusted for '/', then selects the offset back to the value.
+   Each 4 values are packed into 3 bytes within their 32-bit lane.  */
+
+__attribute__ ((__target__ ("ssse3"))) static size_t
+base64_decode_ssse3 (char *dst, const unsigned char *src, size_t n)
+{
+  const __m128i lut_lo = _mm_setr_epi8 (0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+                                        0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lut_hi = _mm_setr_epi8 (0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                        0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                        0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll = _mm_setr_epi8 (0, 16, 19, 4, -65, -65, -71, -71,
+                                          0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i nibble = _mm_set1_epi8 (0x0F);
+  size_t i;
+
+  /* Each block stores 16 bytes, 4 more than it decodes; keep a block in
+     hand to write over them.  */
+  for (i = 0; n - i >= 32; i += 16, dst += 12)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) (src + i));
+      __m128i hi_nibbles = _mm_and_si128 (_mm_srli_epi32 (in, 4), nibble);
+      __m128i lo = _mm_shuffle_epi8 (lut_lo, _mm_and_si128 (in, nibble));
+      __m128i hi = _mm_shuffle_epi8 (lut_hi, hi_nibbles);
+      __m128i roll, values;
+
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_and_si128 (lo, hi),
+                                             _mm_setzero_si128 ())) != 0xFFFF)
+        break;
+      roll = _mm_shuffle_epi8 (lut_roll,
+                               _mm_add_epi8 (_mm_cmpeq_epi8 (in, _mm_set1_epi8 ('/')),
+                                             hi_nibbles));
+      values = _mm_add_epi8 (in, roll);
+      values = _mm_maddubs_epi16 (values, _mm_set1_epi32 (0x01400140));
+      values = _mm_madd_epi16 (values, _mm_set1_epi32 (0x00011000));
+      values = _mm_shuffle_epi8 (values, _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9,
+                                                        8, 14, 13, 12, -1, -1,
+                                                        -1, -1));
+      _mm_storeu_si128 ((__m128i *) dst, values);
+    }
+  return i;
+}
+
+__attribute__ ((__target__ ("avx2"))) static size_t
+base64_decode_avx2 (char *dst, const unsigned char *src, size_t n)
+{
+  const __m256i lut_lo
+    = _mm256_setr_epi8 (0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m256i lut_hi
+    = _mm256_setr_epi8 (0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lut_roll
+    = _mm256_setr_epi8 (0, 16, 19, 4, -65, -65, -71, -71,
+                        0, 0, 0, 0, 0, 0, 0, 0,
+                        0, 16, 19, 4, -65, -65, -71, -71,
+                        0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i nibble = _mm256_set1_epi8 (0x0F);
+  size_t i;
+
+  /* Each block stores 32 bytes, 8 more than it decodes.  */
+  for (i = 0; n - i >= 64; i += 32, dst += 24)
+    {
+      __m256i in = _mm256_loadu_si256 ((const __m256i *) (src + i));
+      __m256i hi_nibbles = _mm256_and_si256 (_mm256_srli_epi32 (in, 4), nibble);
+      __m256i lo = _mm256_shuffle_epi8 (lut_lo, _mm256_and_si256 (in, nibble));
+      __m256i hi = _mm256_shuffle_epi8 (lut_hi, hi_nibbles);
+      __m256i roll, values;
+
+      if (!_mm256_testz_si256 (lo, hi))
+        break;
+      roll = _mm256_shuffle_epi8 (lut_roll,
+                                  _mm256_add_epi8 (_mm256_cmpeq_epi8
+                                                   (in, _mm256_set1_epi8 ('/')),
+                                                   hi_nibbles));
+      values = _mm256_add_epi8 (in, roll);
+      values = _mm256_maddubs_epi16 (values, _mm256_set1_epi32 (0x01400140));
+      values = _mm256_madd_epi16 (values, _mm256_set1_epi32 (0x00011000));
+      values = _mm256_shuffle_epi8 (values,
+                                    _mm256_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9,
+                                                      8, 14, 13, 12, -1, -1, -1, -1,
+                                                      2, 1, 0, 6, 5, 4, 10, 9,
+                                                      8, 14, 13, 12, -1, -1, -1, -1));
+      /* Close the gap between the lanes' 12 bytes.  */
+      values = _mm256_permutevar8x32_epi32 (values,
+                                            _mm256_setr_epi32 (0, 1, 2, 4, 5, 6,
+                                                               3, 7));
+      _mm256_storeu_si256 ((__m256i *) dst, values);
+    }
+  return i + base64_decode_ssse3 (dst, src + i, n - i);
+}
+
+#endif
+
+static struct kernels
+{
+  kernel_fn base16_encode, base16_decode, base64_encode, base64_decode;
+} kernels;
+
+static void
+choose_kernels (void)
+{
+  struct kernels k = { no_kernel, no_kernel, no_kernel, no_kernel };
+
+#if defined __x86_64__ || defined __i386__
+  if (simd_level () >= SIMD_AVX2)
+    k = (struct kernels) { base16_encode_avx2, base16_decode_avx2,
+                           base64_encode_avx2, base64_decode_avx2 };
+  else if (simd_level () >= SIMD_SSSE3)
+    k = (struct kernels) { base16_encode_ssse3, base16_decode_ssse3,
+                           base64_encode_ssse3, base64_decode_ssse3 };
+#endif
+  kernels = k;
+}
+
+#define KERNEL(name) \
+  (kernels.name ? kernels.name : (choose_kernels (), kernels.name))
+
+/* Append the 2 * LEN lowercase hex digits of the bytes at DATA.  */
+
+void
+obstack_grow_base16 (struct obstack *h, const void *data, size_t len)
+{
+  const unsigned char *src = data;
+  char *dst;
+  size_t i;
+
+  if (len > (_OBSTACK_SIZE_T) -1 / 2)
+    _obstack_alloc_failed (h);
+  obstack_make_room (h, 2 * len);
+  dst = obstack_next_free (h);
+
+  i = KERNEL (base16_encode) (dst, src, len);
+  for (; i < len; i++)
+    {
+      dst[2 * i] = hex_digits[src[i] >> 4];
+      dst[2 * i + 1] = hex_digits[src[i] & 15];
+    }
+  obstack_blank_fast (h, 2 * len);
+}
+
+/* Append the bytes whose hex digits, in either case, are the LEN
+   characters at TEXT.  Return 0, or -1 and append nothing if LEN is odd
+   or TEXT has anything but hex digits.  */
+
+int
+obstack_grow_base16_decode (struct obstack *h, const char *text, size_t len)
+{
+  const unsigned char *src = (const unsigned char *) text;
+  char *dst;
+  size_t i;
+
+  if (len % 2)
+    return -1;
+  obstack_make_room (h, len / 2);
+  dst = obstack_next_free (h);
+
+  i = KERNEL (base16_decode) (dst, src, len);
+  for (; i < len; i += 2)
+    {
+      int hi = VALUE (hex_values, src[i]);
+      int lo = VALUE (hex_values, src[i + 1]);
+
+      if ((hi | lo) < 0)
+        return -1;
+      dst[i / 2] = hi << 4 | lo;
+    }
+  obstack_blank_fast (h, len / 2);
+  return 0;
+}
+
+/* Append the base64 encoding of the LEN bytes at DATA, in the standard
+   alphabet of RFC 4648 and padded with '='.  */
+
+void
+obstack_grow_base64 (struct obstack *h, const void *data, size_t len)
+{
+  const unsigned char *src = data;
+  size_t out, i;
+  char *dst, *p;
+
+  if (len > (_OBSTACK_SIZE_T) -1 / 4 * 3 - 2)
+    _obstack_alloc_failed (h);
+  out = (len + 2) / 3 * 4;
+  obstack_make_room (h, out);
+  dst = obstack_next_free (h);
+
+  i = KERNEL (base64_encode) (dst, src, len);
+  p = dst + i / 3 * 4;
+  for (; len - i >= 3; i += 3, p += 4)
+    {
+      uint32_t v = (uint32_t) src[i] << 16 | src[i + 1] << 8 | src[i + 2];
+
+      p[0] = b64_digits[v >> 18];
+      p[1] = b64_digits[v >> 12 & 63];
+      p[2] = b64_digits[v >> 6 & 63];
+      p[3] = b64_digits[v & 63];
+    }
+  if (i < len)
+    {
+      uint32_t v = (uint32_t) src[i] << 16 | (len - i > 1 ? src[i + 1] << 8 : 0);
+
+      p[0] = b64_digits[v >> 18];
+      p[1] = b64_digits[v >> 12 & 63];
+      p[2] = len - i > 1 ? b64_digits[v >> 6 & 63] : '=';
+      p[3] = '=';
+    }
+  obstack_blank_fast (h, out);
+}
+
+/* Append the bytes encoded in base64 by the LEN characters at TEXT.  The
+   '=' padding may be left out, but not be misplaced.  Return 0, or -1
+   and append nothing if TEXT is not valid base64; white space is not
+   allowed either.  */
+
+int
+obstack_grow_base64_decode (struct obstack *h, const char *text, size_t len)
+{
+  const unsigned char *src = (const unsigned char *) text;
+  size_t out, i;
+  char *dst, *p;
+
+  if (len % 4 == 0 && len > 0 && src[len - 1] == '=')
+    len -= src[len - 2] == '=' ? 2 : 1;
+  if (len % 4 == 1)
+    return -1;
+  out = len / 4 * 3 + (len % 4 ? len % 4 - 1 : 0);
+  obstack_make_room (h, out);
+  dst = obstack_next_free (h);
+
+  i = KERNEL (base64_decode) (dst, src, len);
+  p = dst + i / 4 * 3;
+  for (; i < len; i += 4)
+    {
+      size_t n = len - i < 4 ? len - i : 4;
+      uint32_t v = 0;
+      size_t k;
+
+      for (k = 0; k < 4; k++)
+        {
+          int c = k < n ? VALUE (b64_values, src[i + k]) : 0;
+
+          if (c < 0)
+            return -1;
+          v = v << 6 | c;
+        }
+      *p++ = v >> 16;
+      if (n > 2)
+        *p++ = v >> 8;
+      if (n > 3)
+        *p++ = v;
+    }
+  obstack_blank_fast (h, out);
+  return 0;
+}
@@ -0,0 +1,175 @@
+/* obstack_coroutine.hh - C++20 coroutine frames in obstacks
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   A promise type that derives from ObstackFrames has the frames of its
+   coroutines allocated from an obstack instead of the heap:
+
+        struct Task
+        {
+          struct promise_type : gnulib::ObstackFrames
+          {
+            ...
+          };
+        };
+
+        void
+        handle_request (...)
+        {
+          struct obstack ob;
+          obstack_init (&ob);
+          {
+            gnulib::ObstackFrameScope scope (&ob);
+            run (serve (...));          -- frames come from ob
+          }
+          obstack_free (&ob, NULL);    -- and go with it
+        }
+
+   The obstack is the one named by the innermost ObstackFrameScope of
+   the thread creating the coroutine; with none, frames come from the
+   heap as usual.  A frame remembers where it came from, so it may be
+   destroyed on any thread and after the scope has ended, but not after
+   its obstack has been freed.
+
+   Destroying the frame that is last in its obstack rewinds the obstack
+   over it, so that coroutines finishing in the reverse order of their
+   creation reuse the same space.  Frames are never carved from the
+   tails that obstack_alloc reuses, where they could not be rewound.
+   Other frames stay until the obstack is freed or rewound.  Frames are
+   aligned as operator new aligns them, whatever the alignment of the
+   obstack.  The scope must not be used while an object is growing in
+   the obstack.  Allocation failure throws std::bad_alloc.  */
+
+#ifndef _OBSTACK_COROUTINE_HH
+#define _OBSTACK_COROUTINE_HH 1
+
+#include "obstack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace gnulib
+{
+
+namespace coroutine_detail
+{
+
+/* The obstack new frames are put in, for this thread.  */
+inline thread_local struct obstack *current_obstack;
+
+/* In front of every frame: the obstack it is in, or null for the heap,
+   and where its object in the obstack starts.  The size keeps the frame
+   aligned as operator new would.  */
+struct alignas (__STDCPP_DEFAULT_NEW_ALIGNMENT__) FrameHeader
+{
+  struct obstack *obstack;
+  void *start;
+};
+
+/* The bytes a frame in H needs beyond its header and itself so that
+   the header can be moved up to the alignment operator new gives.  */
+inline std::size_t
+frame_slack (struct obstack *h) noexcept
+{
+  std::size_t align = obstack_alignment_mask (h) + 1;
+  return (align < __STDCPP_DEFAULT_NEW_ALIGNMENT__
+          ? __STDCPP_DEFAULT_NEW_ALIGNMENT__ - align : 0);
+}
+
+}       /* namespace coroutine_detail */
+
+/* Makes H the obstack for coroutine frames created on this thread
+   during its lifetime.  */
+
+class ObstackFrameScope
+{
+public:
+  explicit ObstackFrameScope (struct obstack *h) noexcept
+    : prev_ (coroutine_detail::current_obstack)
+  {
+    coroutine_detail::current_obstack = h;
+  }
+
+  ObstackFrameScope (const ObstackFrameScope &) = delete;
+  ObstackFrameScope &operator= (const ObstackFrameScope &) = delete;
+
+  ~ObstackFrameScope () { coroutine_detail::current_obstack = prev_; }
+
+private:
+  struct obstack *prev_;
+};
+
+/* Base for promise types, providing the allocation functions that
+   coroutines use for their frames.  */
+
+struct ObstackFrames
+{
+  static void *
+  operator new (std::size_t size)
+  {
+    using coroutine_detail::FrameHeader;
+    struct obstack *h = coroutine_detail::current_obstack;
+    std::size_t slack = h ? coroutine_detail::frame_slack (h) : 0;
+    FrameHeader *hd;
+    void *start = nullptr;
+
+    if (size > (_OBSTACK_SIZE_T) -1 - sizeof (FrameHeader) - slack)
+      throw std::bad_alloc ();
+    if (h)
+      {
+        /* Grown rather than allocated, so as not to land in a tail.  */
+        std::uintptr_t align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+        if (!obstack_try_blank (h, sizeof *hd + slack + size))
+          throw std::bad_alloc ();
+        start = obstack_finish (h);
+        hd = reinterpret_cast<FrameHeader *> (((std::uintptr_t) start
+                                               + align - 1) & ~(align - 1));
+      }
+    else
+      hd = static_cast<FrameHeader *> (::operator new (sizeof *hd + size));
+    hd->obstack = h;
+    hd->start = start;
+    return hd + 1;
+  }
+
+  static void
+  operator delete (void *p, std::size_t size) noexcept
+  {
+    using coroutine_detail::FrameHeader;
+    FrameHeader *hd = static_cast<FrameHeader *> (p) - 1;
+    struct obstack *h = hd->obstack;
+
+    if (!h)
+      ::operator delete (hd);
+    else
+      {
+        /* Where obstack_finish left the next object.  */
+        std::uintptr_t mask = obstack_alignment_mask (h);
+        std::uintptr_t last = ((std::uintptr_t) hd->start + sizeof *hd
+                               + coroutine_detail::frame_slack (h) + size);
+        void *end = (void *) ((last + mask) & ~mask);
+
+        if (obstack_object_size (h) == 0 && end == obstack_next_free (h))
+          obstack_free (h, hd->start);
+      }
+  }
+};
+
+}       /* namespace gnulib */
+
+#endif /* _OBSTACK_COROUTINE_HH */
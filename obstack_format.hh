@@ -0,0 +1,554 @@
+/* obstack_format.hh - type-safe formatting into obstacks for C++
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   format_to appends formatted text to the object growing in an obstack,
+   with the format string given as a template argument (C++20):
+
+        gnulib::format_to<"{}: {:08x} {}\n"> (&ob, name, id, ratio);
+
+   The format is parsed at compile time.  Each '{}' stands for the next
+   argument; '{{' and '}}' stand for braces.  A replacement field may
+   hold a specification ':' [0] [WIDTH] [TYPE], where 0 pads numbers
+   with zeros instead of spaces, WIDTH is a minimum width (numbers are
+   right-aligned, strings left-aligned) and TYPE is one of d, x, X or o
+   for integers, s for strings or c for char.  Doubles take no
+   specification, and only integers take the 0.  A format with the
+   wrong number of fields, or a specification an argument's type does
+   not take, does not compile.
+
+   Arguments may be integers, bool, char, double and float, C strings,
+   std::string, std::string_view and pointers.  Other types can be added
+   by specializing gnulib::Formatter; see the specializations below.
+
+   The obstack first makes room, once, for the longest text the call can
+   produce, and everything is then written straight into that room
+   through an ObstackAppender.  Allocation failure throws
+   std::bad_alloc.  The text is not nul-terminated.  */
+
+#ifndef _OBSTACK_FORMAT_HH
+#define _OBSTACK_FORMAT_HH 1
+
+#include "obstack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace gnulib
+{
+
+/* A format string usable as a template argument.  */
+
+template <std::size_t N>
+struct FormatString
+{
+  char data[N];
+
+  constexpr FormatString (const char (&s)[N])
+  {
+    for (std::size_t i = 0; i < N; i++)
+      data[i] = s[i];
+  }
+};
+
+struct FormatSpec
+{
+  char type = 0;                /* d, x, X, o, s, c, or 0 for none */
+  bool zero = false;            /* pad with zeros */
+  unsigned width = 0;           /* minimum width */
+};
+
+/* Output iterator writing into room already made in an obstack.  Each
+   write goes straight to the end of the current object, without the
+   checks of obstack_1grow and obstack_grow.  */
+
+class ObstackAppender
+{
+public:
+  using iterator_category = std::output_iterator_tag;
+  using value_type = void;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = void;
+
+  explicit ObstackAppender (struct obstack *h) noexcept : h_ (h) {}
+
+  ObstackAppender &operator* () noexcept { return *this; }
+  ObstackAppender &operator++ () noexcept { return *this; }
+  ObstackAppender &operator++ (int) noexcept { return *this; }
+
+  ObstackAppender &
+  operator= (char c) noexcept
+  {
+    obstack_1grow_fast (h_, c);
+    return *this;
+  }
+
+  void
+  append (const char *s, std::size_t n) noexcept
+  {
+    std::memcpy (obstack_next_free (h_), s, n);
+    obstack_blank_fast (h_, n);
+  }
+
+  void
+  fill (char c, std::size_t n) noexcept
+  {
+    std::memset (obstack_next_free (h_), c, n);
+    obstack_blank_fast (h_, n);
+  }
+
+  struct obstack *obstack () const noexcept { return h_; }
+
+private:
+  struct obstack *h_;
+};
+
+/* Formatter<T> formats arguments of type T.  It provides
+
+     static constexpr bool accepts (FormatSpec);
+     static std::size_t max_size (const T &, FormatSpec);
+     static void write (ObstackAppender &, const T &, FormatSpec);
+
+   where max_size bounds the length of what write appends.  The
+   formatter is chosen by the decayed type of the argument, so that
+   arrays of char are formatted as const char *.  */
+
+template <typename T, typename Enable = void>
+struct Formatter;
+
+namespace format_detail
+{
+
+inline std::size_t
+padded (std::size_t n, FormatSpec spec) noexcept
+{
+  return n > spec.width ? n : spec.width;
+}
+
+inline void
+write_integer (ObstackAppender &out, std::uintmax_t v, bool neg,
+               FormatSpec spec) noexcept
+{
+  int base = (spec.type == 'x' || spec.type == 'X' ? 16
+              : spec.type == 'o' ? 8 : 10);
+  std::size_t n = _obstack_count_digits (v, base);
+  std::size_t len = padded (n + neg, spec);
+  char *p;
+
+  if (!spec.zero)
+    out.fill (' ', len - n - neg);
+  if (neg)
+    out = '-';
+  if (spec.zero)
+    out.fill ('0', len - n - neg);
+  p = (char *) obstack_next_free (out.obstack ());
+  _obstack_put_digits (p + n, v, base, spec.type == 'X');
+  obstack_blank_fast (out.obstack (), n);
+}
+
+inline void
+write_string (ObstackAppender &out, const char *s, std::size_t n,
+              FormatSpec spec) noexcept
+{
+  out.append (s, n);
+  if (spec.width > n)
+    out.fill (' ', spec.width - n);
+}
+
+}       /* namespace format_detail */
+
+template <typename T>
+struct Formatter<T, std::enable_if_t<std::is_integral_v<T>
+                                     && sizeof (T) <= sizeof (std::uint64_t)
+                                     && !std::is_same_v<T, bool>
+                                     && !std::is_same_v<T, char>>>
+{
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return (spec.type == 0 || spec.type == 'd' || spec.type == 'x'
+            || spec.type == 'X' || spec.type == 'o');
+  }
+
+  static std::size_t
+  max_size (const T &, FormatSpec spec) noexcept
+  {
+    /* Octal digits of a 64-bit number, and a sign.  */
+    return format_detail::padded (23, spec);
+  }
+
+  static void
+  write (ObstackAppender &out, const T &v, FormatSpec spec) noexcept
+  {
+    if constexpr (std::is_signed_v<T>)
+      format_detail::write_integer (out, v < 0 ? -(std::uintmax_t) v
+                                               : (std::uintmax_t) v,
+                                    v < 0, spec);
+    else
+      format_detail::write_integer (out, v, false, spec);
+  }
+};
+
+template <>
+struct Formatter<bool>
+{
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return spec.type == 0 && !spec.zero;
+  }
+
+  static std::size_t
+  max_size (const bool &, FormatSpec spec) noexcept
+  {
+    return format_detail::padded (5, spec);
+  }
+
+  static void
+  write (ObstackAppender &out, const bool &v, FormatSpec spec) noexcept
+  {
+    format_detail::write_string (out, v ? "true" : "false", v ? 4 : 5, spec);
+  }
+};
+
+template <>
+struct Formatter<char>
+{
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return (spec.type == 0 || spec.type == 'c') && !spec.zero;
+  }
+
+  static std::size_t
+  max_size (const char &, FormatSpec spec) noexcept
+  {
+    return format_detail::padded (1, spec);
+  }
+
+  static void
+  write (ObstackAppender &out, const char &c, FormatSpec spec) noexcept
+  {
+    format_detail::write_string (out, &c, 1, spec);
+  }
+};
+
+/* Doubles are written as by obstack_grow_double, as the shortest text
+   that reads back as the same value.  */
+
+template <typename T>
+struct Formatter<T, std::enable_if_t<std::is_floating_point_v<T>
+                                     && sizeof (T) <= sizeof (double)>>
+{
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return spec.type == 0 && !spec.zero && spec.width == 0;
+  }
+
+  static std::size_t
+  max_size (const T &, FormatSpec) noexcept
+  {
+    return 25;
+  }
+
+  static void
+  write (ObstackAppender &out, const T &v, FormatSpec) noexcept
+  {
+    obstack_grow_double (out.obstack (), v);
+  }
+};
+
+template <>
+struct Formatter<std::string_view>
+{
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return (spec.type == 0 || spec.type == 's') && !spec.zero;
+  }
+
+  static std::size_t
+  max_size (const std::string_view &s, FormatSpec spec) noexcept
+  {
+    return format_detail::padded (s.size (), spec);
+  }
+
+  static void
+  write (ObstackAppender &out, const std::string_view &s,
+         FormatSpec spec) noexcept
+  {
+    format_detail::write_string (out, s.data (), s.size (), spec);
+  }
+};
+
+template <typename Traits, typename Alloc>
+struct Formatter<std::basic_string<char, Traits, Alloc>>
+{
+  using String = std::basic_string<char, Traits, Alloc>;
+
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return Formatter<std::string_view>::accepts (spec);
+  }
+
+  static std::size_t
+  max_size (const String &s, FormatSpec spec) noexcept
+  {
+    return format_detail::padded (s.size (), spec);
+  }
+
+  static void
+  write (ObstackAppender &out, const String &s, FormatSpec spec) noexcept
+  {
+    format_detail::write_string (out, s.data (), s.size (), spec);
+  }
+};
+
+/* A null C string is written as "(null)", as by obstack_printf.  */
+
+template <>
+struct Formatter<const char *>
+{
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return Formatter<std::string_view>::accepts (spec);
+  }
+
+  static std::size_t
+  max_size (const char *const &s, FormatSpec spec) noexcept
+  {
+    return format_detail::padded (s ? std::strlen (s) : 6, spec);
+  }
+
+  static void
+  write (ObstackAppender &out, const char *const &s, FormatSpec spec) noexcept
+  {
+    if (s)
+      format_detail::write_string (out, s, std::strlen (s), spec);
+    else
+      format_detail::write_string (out, "(null)", 6, spec);
+  }
+};
+
+template <>
+struct Formatter<char *> : Formatter<const char *>
+{
+};
+
+/* Other pointers are written in hex with a "0x" prefix.  */
+
+template <typename T>
+struct Formatter<T *, std::enable_if_t<!std::is_same_v<std::remove_cv_t<T>,
+                                                       char>>>
+{
+  static constexpr bool
+  accepts (FormatSpec spec)
+  {
+    return spec.type == 0 && !spec.zero;
+  }
+
+  static std::size_t
+  max_size (T *const &, FormatSpec spec) noexcept
+  {
+    return format_detail::padded (2 + 2 * sizeof (void *), spec);
+  }
+
+  static void
+  write (ObstackAppender &out, T *const &p, FormatSpec spec) noexcept
+  {
+    std::uintptr_t v = (std::uintptr_t) p;
+    std::size_t n = _obstack_count_digits (v, 16);
+
+    if (spec.width > n + 2)
+      out.fill (' ', spec.width - n - 2);
+    out.append ("0x", 2);
+    _obstack_put_digits ((char *) obstack_next_free (out.obstack ()) + n,
+                         v, 16, 0);
+    obstack_blank_fast (out.obstack (), n);
+  }
+};
+
+namespace format_detail
+{
+
+/* A piece of a format: literal text, or the replacement field for
+   argument ARG.  */
+
+struct Segment
+{
+  std::size_t begin = 0, length = 0;
+  int arg = -1;
+  FormatSpec spec;
+};
+
+/* Parse FMT into SEGS, which may be null, and return the number of
+   segments, or -1 if FMT is malformed.  */
+
+template <std::size_t N>
+constexpr int
+parse (const char (&fmt)[N], Segment *segs)
+{
+  std::size_t i = 0, n = N - 1;
+  int count = 0, arg = 0;
+
+  while (i < n)
+    {
+      Segment s;
+
+      if (fmt[i] == '{' && i + 1 < n && fmt[i + 1] != '{')
+        {
+          i++;
+          if (fmt[i] == ':')
+            {
+              i++;
+              if (i < n && fmt[i] == '0')
+                s.spec.zero = true, i++;
+              for (; i < n && fmt[i] >= '0' && fmt[i] <= '9'; i++)
+                s.spec.width = s.spec.width * 10 + (fmt[i] - '0');
+              if (i < n && fmt[i] != '}')
+                s.spec.type = fmt[i++];
+            }
+          if (i >= n || fmt[i] != '}')
+            return -1;
+          i++;
+          s.arg = arg++;
+        }
+      else if (fmt[i] == '{' || fmt[i] == '}')
+        {
+          /* A doubled brace, written once.  */
+          if (i + 1 >= n || fmt[i + 1] != fmt[i])
+            return -1;
+          s.begin = i;
+          s.length = 1;
+          i += 2;
+        }
+      else
+        {
+          s.begin = i;
+          while (i < n && fmt[i] != '{' && fmt[i] != '}')
+            i++;
+          s.length = i - s.begin;
+        }
+      if (segs)
+        segs[count] = s;
+      count++;
+    }
+  return count;
+}
+
+template <FormatString Fmt>
+struct Parsed
+{
+  static constexpr int parsed = parse (Fmt.data, nullptr);
+  static_assert (parsed >= 0, "malformed format string");
+  static constexpr std::size_t count = parsed > 0 ? parsed : 0;
+
+  struct Table
+  {
+    Segment segs[count + 1];
+    int args = 0;
+    std::size_t literal = 0;
+  };
+
+  static constexpr Table table = []
+    {
+      Table t{};
+      if (parsed > 0)
+        parse (Fmt.data, t.segs);
+      for (std::size_t i = 0; i < count; i++)
+        if (t.segs[i].arg < 0)
+          t.literal += t.segs[i].length;
+        else
+          t.args++;
+      return t;
+    } ();
+};
+
+template <FormatString Fmt, std::size_t I, typename Tuple>
+inline std::size_t
+segment_size (const Tuple &args)
+{
+  constexpr Segment s = Parsed<Fmt>::table.segs[I];
+
+  if constexpr (s.arg < 0)
+    return 0;
+  else
+    {
+      using T = std::decay_t<std::tuple_element_t<s.arg, Tuple>>;
+      static_assert (Formatter<T>::accepts (s.spec),
+                     "format specification does not suit the argument");
+      return Formatter<T>::max_size (std::get<s.arg> (args), s.spec);
+    }
+}
+
+template <FormatString Fmt, std::size_t I, typename Tuple>
+inline void
+write_segment (ObstackAppender &out, const Tuple &args)
+{
+  constexpr Segment s = Parsed<Fmt>::table.segs[I];
+
+  if constexpr (s.arg < 0)
+    out.append (Fmt.data + s.begin, s.length);
+  else
+    {
+      using T = std::decay_t<std::tuple_element_t<s.arg, Tuple>>;
+      Formatter<T>::write (out, std::get<s.arg> (args), s.spec);
+    }
+}
+
+template <FormatString Fmt, typename Tuple, std::size_t... I>
+inline void
+format (struct obstack *h, const Tuple &args, std::index_sequence<I...>)
+{
+  std::size_t size = Parsed<Fmt>::table.literal;
+  ObstackAppender out (h);
+
+  ((size += segment_size<Fmt, I> (args)), ...);
+  if (!obstack_try_make_room (h, size))
+    throw std::bad_alloc ();
+  (write_segment<Fmt, I> (out, args), ...);
+}
+
+}       /* namespace format_detail */
+
+template <FormatString Fmt, typename... Args>
+inline void
+format_to (struct obstack *h, const Args &...args)
+{
+  using P = format_detail::Parsed<Fmt>;
+  static_assert (P::table.args == sizeof... (Args),
+                 "format string and arguments do not match");
+
+  format_detail::format<Fmt> (h, std::forward_as_tuple (args...),
+                              std::make_index_sequence<P::count> ());
+}
+
+}       /* namespace gnulib */
+
+#endif /* _OBSTACK_FORMAT_HH */
@@ -0,0 +1,221 @@
+/* obstack_json.c - write JSON text into obstacks
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification.  */
+#include "obstack_json.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "simd.h"
+
+/* Longest text of a JSON number written by this file.  */
+enum { NUMBER_MAX_WIDTH = 25 };
+
+/* The escape for each byte below 0x20, '"' and '\\', as its second
+   character ('u' for \u00XX), and 0 for bytes copied as they are.  */
+
+static const char escapes[256] =
+{
+  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+  0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+};
+
+/* The same bytes as a set for simd_byteset_scan: the 32 control
+   characters (bits 0 and 1 of every entry of LO), '"' (0x22, bit 2 of
+   LO[2]) and '\\' (0x5C, bit 5 of LO[12]).  */
+
+static const struct simd_byteset escaped =
+{
+  { 3, 3, 7, 3, 3, 3, 3, 3, 3, 3, 3, 3, 35, 3, 3, 3 },
+  { 0 },
+  34,
+  { 0 }
+};
+
+void
+obstack_json_init (struct obstack_json *j, struct obstack *h)
+{
+  memset (j, 0, sizeof *j);
+  j->obstack = h;
+}
+
+/* Make room for the separator before a value and LENGTH more bytes, and
+   write the separator.  */
+
+static void
+begin_value (struct obstack_json *j, size_t length)
+{
+  struct obstack *h = j->obstack;
+  uint64_t *word = &j->comma[j->depth / 64];
+  uint64_t bit = (uint64_t) 1 << (j->depth % 64);
+
+  obstack_make_room (h, length + 1);
+  if (j->after_key)
+    j->after_key = 0;
+  else if (*word & bit)
+    obstack_1grow_fast (h, ',');
+  *word |= bit;
+}
+
+static void
+begin_container (struct obstack_json *j, char c)
+{
+  begin_value (j, 1);
+  obstack_1grow_fast (j->obstack, c);
+  if (++j->depth >= OBSTACK_JSON_MAX_DEPTH)
+    abort ();
+  j->comma[j->depth / 64] &= ~((uint64_t) 1 << (j->depth % 64));
+}
+
+static void
+end_container (struct obstack_json *j, char c)
+{
+  if (j->depth == 0)
+    abort ();
+  j->depth--;
+  obstack_1grow (j->obstack, c);
+}
+
+void
+obstack_json_begin_object (struct obstack_json *j)
+{
+  begin_container (j, '{');
+}
+
+void
+obstack_json_end_object (struct obstack_json *j)
+{
+  end_container (j, '}');
+}
+
+void
+obstack_json_begin_array (struct obstack_json *j)
+{
+  begin_container (j, '[');
+}
+
+void
+obstack_json_end_array (struct obstack_json *j)
+{
+  end_container (j, ']');
+}
+
+/* Write S, of length LEN, as a quoted JSON string followed by the
+   nul-terminated SUFFIX, after the separator.  */
+
+static void
+put_string (struct obstack_json *j, const char *s, size_t len,
+            const char *suffix)
+{
+  static const char xdigits[] = "0123456789abcdef";
+  struct obstack *h = j->obstack;
+  const char *end = s + len;
+  char *p;
+
+  /* Every byte might turn into a six-byte \u00XX escape.  */
+  if (len > (_OBSTACK_SIZE_T) -1 / 8)
+    _obstack_alloc_failed (h);
+  begin_value (j, 6 * len + 2 + strlen (suffix));
+
+  p = obstack_next_free (h);
+  *p++ = '"';
+  for (;;)
+    {
+      size_t n = simd_byteset_scan (&escaped, s, end - s);
+      unsigned char c;
+
+      memcpy (p, s, n);
+      p += n;
+      s += n;
+      if (s == end)
+        break;
+      c = *s++;
+      *p++ = '\\';
+      *p++ = escapes[c];
+      if (escapes[c] == 'u')
+        {
+          memcpy (p, "00", 2);
+          p[2] = xdigits[c >> 4];
+          p[3] = xdigits[c & 15];
+          p += 4;
+        }
+    }
+  *p++ = '"';
+  while (*suffix)
+    *p++ = *suffix++;
+  obstack_blank_fast (h, p - (char *) obstack_next_free (h));
+}
+
+void
+obstack_json_key (struct obstack_json *j, const char *key, size_t len)
+{
+  put_string (j, key, len, ":");
+  j->after_key = 1;
+}
+
+void
+obstack_json_string (struct obstack_json *j, const char *s, size_t len)
+{
+  put_string (j, s, len, "");
+}
+
+void
+obstack_json_int (struct obstack_json *j, int64_t v)
+{
+  begin_value (j, NUMBER_MAX_WIDTH);
+  obstack_grow_i64 (j->obstack, v);
+}
+
+void
+obstack_json_uint (struct obstack_json *j, uint64_t v)
+{
+  begin_value (j, NUMBER_MAX_WIDTH);
+  obstack_grow_u64 (j->obstack, v);
+}
+
+/* JSON has no infinities or NaNs; write null for them.  */
+
+void
+obstack_json_double (struct obstack_json *j, double v)
+{
+  begin_value (j, NUMBER_MAX_WIDTH);
+  if (v - v == 0)
+    obstack_grow_double (j->obstack, v);
+  else
+    obstack_grow (j->obstack, "null", 4);
+}
+
+void
+obstack_json_bool (struct obstack_json *j, int v)
+{
+  begin_value (j, 5);
+  if (v)
+    obstack_grow (j->obstack, "true", 4);
+  else
+    obstack_grow (j->obstack, "false", 5);
+}
+
+void
+obstack_json_null (struct obstack_json *j)
+{
+  begin_value (j, 4);
+  obstack_grow (j->obstack, "null", 4);
+}
@@ -0,0 +1,88 @@
+/* obstack_json.h - write JSON text into obstacks
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   A JSON writer appends a document to the object growing in an obstack,
+   inserting commas and colons itself:
+
+        struct obstack_json j;
+        obstack_json_init (&j, &ob);
+        obstack_json_begin_object (&j);
+        obstack_json_key (&j, "id", 2);
+        obstack_json_int (&j, 42);
+        obstack_json_key (&j, "tags", 4);
+        obstack_json_begin_array (&j);
+        obstack_json_string (&j, "a\"b", 3);
+        obstack_json_end_array (&j);
+        obstack_json_end_object (&j);
+        char *text = obstack_finish (&ob);  -- {"id":42,"tags":["a\"b"]}
+
+   Each value makes room in the obstack at most once, for the longest
+   text it could produce, and is then written straight into that room.
+   Strings are copied in bulk between the bytes that need escaping,
+   which are found a vector at a time with simd_byteset_scan.
+   Strings are taken as UTF-8 and passed through unchanged apart from
+   the escapes JSON requires.  The document is not nul-terminated.
+
+   Nesting objects and arrays OBSTACK_JSON_MAX_DEPTH deep, or ending a
+   container that was not begun, calls abort.  */
+
+#ifndef _OBSTACK_JSON_H
+#define _OBSTACK_JSON_H 1
+
+#include "obstack.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* One more than the deepest nesting of objects and arrays a writer
+   supports.  */
+#define OBSTACK_JSON_MAX_DEPTH 256
+
+struct obstack_json
+{
+  struct obstack *obstack;      /* where the text goes */
+  unsigned depth;               /* number of open objects and arrays */
+  int after_key;                /* a key was just written */
+  uint64_t comma[OBSTACK_JSON_MAX_DEPTH / 64]; /* bit D set: the container
+                                                  at depth D has a member */
+};
+
+extern void obstack_json_init (struct obstack_json *, struct obstack *);
+
+extern void obstack_json_begin_object (struct obstack_json *);
+extern void obstack_json_end_object (struct obstack_json *);
+extern void obstack_json_begin_array (struct obstack_json *);
+extern void obstack_json_end_array (struct obstack_json *);
+
+extern void obstack_json_key (struct obstack_json *, const char *, size_t);
+extern void obstack_json_string (struct obstack_json *, const char *, size_t);
+extern void obstack_json_int (struct obstack_json *, int64_t);
+extern void obstack_json_uint (struct obstack_json *, uint64_t);
+extern void obstack_json_double (struct obstack_json *, double);
+extern void obstack_json_bool (struct obstack_json *, int);
+extern void obstack_json_null (struct obstack_json *);
+
+#ifdef __cplusplus
+}       /* C++ */
+#endif
+
+#endif /* _OBSTACK_JSON_H */
@@ -0,0 +1,344 @@
+/* obstack_malloc.c - malloc family on top of a single obstack
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   A replacement malloc for short-lived programs, meant to be preloaded:
+
+        cc -shared -fPIC -O2 -o libobstack_malloc.so \
+           obstack_malloc.c obstack.c simd.c
+        LD_PRELOAD=./libobstack_malloc.so some-tool ...
+
+   Every block is bump-allocated from one process-wide obstack whose
+   chunks are large anonymous mappings, so that pages are only touched
+   as they are used.  'free' gives memory back only for the most recently
+   allocated block, and 'realloc' of that block grows or shrinks it in
+   place.  Other blocks stay allocated until the process exits, at which
+   point nothing is freed at all.  Blocks too large to be worth keeping in
+   a chunk get their own mapping and are unmapped by 'free'.
+
+   This trades memory for speed and suits programs that start, do their
+   work and exit.  Long-running programs that free and reallocate in
+   arbitrary order should keep the libc allocator.  */
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE 1          /* for mremap */
+#endif
+
+#include "obstack.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Preferred size of a chunk.  Only the pages actually used are ever
+   backed by memory.  */
+#ifndef OBSTACK_MALLOC_CHUNK
+# define OBSTACK_MALLOC_CHUNK (64 * 1024 * 1024)
+#endif
+
+/* Blocks of at least this many bytes get a mapping of their own.  */
+#ifndef OBSTACK_MALLOC_LARGE
+# define OBSTACK_MALLOC_LARGE (1024 * 1024)
+#endif
+
+/* Alignment of every block, as for the libc malloc.  */
+#define ALIGNMENT 16
+
+/* Header in front of every block.  BASE is what obstack_alloc returned
+   for the block, which differs from the header address only for blocks
+   aligned beyond ALIGNMENT.  For blocks with a mapping of their own,
+   BASE is the mapping with its low bit set, and the first word of the
+   mapping holds its length.  */
+
+struct header
+{
+  size_t size;                  /* bytes requested */
+  char *base;                   /* start of the obstack object */
+};
+
+#define HEADER(p) ((struct header *) (p) - 1)
+#define MAPPED(hd) ((uintptr_t) (hd)->base & 1)
+#define ROUND(n, a) (((n) + (a) - 1) & ~(size_t) ((a) - 1))
+
+static struct obstack heap;
+static int heap_ready;
+static volatile char heap_lock;
+
+static void
+lock (void)
+{
+  while (__atomic_test_and_set (&heap_lock, __ATOMIC_ACQUIRE))
+    while (heap_lock)
+      {
+#if defined __i386__ || defined __x86_64__
+        __builtin_ia32_pause ();
+#endif
+      }
+}
+
+static void
+unlock (void)
+{
+  __atomic_clear (&heap_lock, __ATOMIC_RELEASE);
+}
+
+static void *
+map (size_t size)
+{
+  void *p = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+}
+
+/* Chunk functions of the heap obstack.  */
+
+static void *
+chunk_alloc (size_t size)
+{
+  return map (size);
+}
+
+static void
+chunk_free (void *chunk)
+{
+  munmap (chunk, ((struct _obstack_chunk *) chunk)->limit - (char *) chunk);
+}
+
+/* Allocate SIZE bytes aligned to ALIGN, a power of 2.  */
+
+static void *
+allocate (size_t size, size_t align)
+{
+  struct header *hd;
+  size_t extra = align <= ALIGNMENT ? 0 : align - ALIGNMENT;
+  size_t total = sizeof *hd + extra + size;
+  char *base, *p;
+
+  if (total < size)
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+
+  if (total >= OBSTACK_MALLOC_LARGE)
+    {
+      /* Room for the length before the header, as well.  */
+      size_t len = ROUND (total + sizeof *hd, (size_t) sysconf (_SC_PAGESIZE));
+      if (len < total || !(base = map (len)))
+        {
+          errno = ENOMEM;
+          return NULL;
+        }
+      *(size_t *) base = len;
+      p = (char *) ROUND ((uintptr_t) base + 2 * sizeof *hd,
+                          align < ALIGNMENT ? ALIGNMENT : align);
+      hd = HEADER (p);
+      hd->size = size;
+      hd->base = (char *) ((uintptr_t) base | 1);
+      return p;
+    }
+
+  lock ();
+  if (!heap_ready)
+    {
+      obstack_specify_allocation (&heap, OBSTACK_MALLOC_CHUNK, ALIGNMENT,
+                                  chunk_alloc, chunk_free);
+      heap_ready = 1;
+    }
+  base = obstack_try_alloc (&heap, total);
+  unlock ();
+  if (!base)
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+  p = (char *) ROUND ((uintptr_t) base + sizeof *hd,
+                      align < ALIGNMENT ? ALIGNMENT : align);
+  hd = HEADER (p);
+  hd->size = size;
+  hd->base = base;
+  return p;
+}
+
+/* Nonzero if P, not a mapped block, is the last block in the heap.
+   Call with the lock held.  */
+
+static int
+is_top (char *p)
+{
+  return p + ROUND (HEADER (p)->size, ALIGNMENT) == heap.next_free;
+}
+
+void *
+malloc (size_t size)
+{
+  return allocate (size, ALIGNMENT);
+}
+
+void
+free (void *ptr)
+{
+  struct header *hd;
+
+  if (!ptr)
+    return;
+  hd = HEADER (ptr);
+  if (MAPPED (hd))
+    {
+      char *base = (char *) ((uintptr_t) hd->base & ~(uintptr_t) 1);
+      munmap (base, *(size_t *) base);
+      return;
+    }
+  lock ();
+  if (is_top (ptr))
+    obstack_free (&heap, hd->base);
+  unlock ();
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  size_t total;
+  void *p;
+
+  if (__builtin_mul_overflow (nmemb, size, &total))
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+  /* Not malloc, which the compiler would fold with the memset into a
+     call to calloc.  */
+  p = allocate (total, ALIGNMENT);
+  /* Fresh mappings are zero already, but rewound heap space may not be.  */
+  if (p && !MAPPED (HEADER (p)))
+    memset (p, 0, total);
+  return p;
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  struct header *hd;
+  void *p;
+
+  if (!ptr)
+    return malloc (size);
+  hd = HEADER (ptr);
+  if (MAPPED (hd))
+    {
+      /* Let the kernel move the pages rather than copying them.  */
+      char *base = (char *) ((uintptr_t) hd->base & ~(uintptr_t) 1);
+      size_t off = (char *) ptr - base;
+      size_t len = ROUND (off + size, (size_t) sysconf (_SC_PAGESIZE));
+      char *nbase;
+
+      if (len < size)
+        {
+          errno = ENOMEM;
+          return NULL;
+        }
+      nbase = mremap (base, *(size_t *) base, len, MREMAP_MAYMOVE);
+      if (nbase == MAP_FAILED)
+        {
+          errno = ENOMEM;
+          return NULL;
+        }
+      *(size_t *) nbase = len;
+      hd = HEADER (nbase + off);
+      hd->size = size;
+      hd->base = (char *) ((uintptr_t) nbase | 1);
+      return nbase + off;
+    }
+  if (size <= hd->size)
+    {
+      lock ();
+      if (is_top (ptr))
+        heap.next_free = heap.object_base
+          = (char *) ptr + ROUND (size, ALIGNMENT);
+      hd->size = size;
+      unlock ();
+      return ptr;
+    }
+
+  /* Grow the last block in place if the chunk has room.  */
+  lock ();
+  if (is_top (ptr) && size < OBSTACK_MALLOC_LARGE
+      && ROUND (size, ALIGNMENT) - ROUND (hd->size, ALIGNMENT)
+         <= (size_t) (heap.chunk_limit - heap.next_free))
+    {
+      heap.next_free = heap.object_base
+        = (char *) ptr + ROUND (size, ALIGNMENT);
+      hd->size = size;
+      unlock ();
+      return ptr;
+    }
+  unlock ();
+
+  p = allocate (size, ALIGNMENT);
+  if (p)
+    {
+      memcpy (p, ptr, hd->size < size ? hd->size : size);
+      free (ptr);
+    }
+  return p;
+}
+
+int
+posix_memalign (void **res, size_t align, size_t size)
+{
+  void *p;
+
+  if (align < sizeof (void *) || (align & (align - 1)))
+    return EINVAL;
+  p = allocate (size, align);
+  if (!p)
+    return ENOMEM;
+  *res = p;
+  return 0;
+}
+
+void *
+aligned_alloc (size_t align, size_t size)
+{
+  if (!align || (align & (align - 1)))
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+  return allocate (size, align);
+}
+
+void *
+memalign (size_t align, size_t size)
+{
+  return aligned_alloc (align, size);
+}
+
+void *
+valloc (size_t size)
+{
+  return allocate (size, (size_t) sysconf (_SC_PAGESIZE));
+}
+
+size_t
+malloc_usable_size (void *ptr)
+{
+  return ptr ? HEADER (ptr)->size : 0;
+}
@@ -0,0 +1,484 @@
+/* obstack_num.c - append numbers to obstacks as text
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification.  */
+#include "obstack.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Each function makes room once for the widest text it can produce,
+   writes straight into it and then advances by what it actually wrote.
+   Like the other growth macros, they add to the current object.  */
+
+/* Most characters in the text of a uint64_t, int64_t or double.  */
+enum { U64_MAX_WIDTH = 20, I64_MAX_WIDTH = 20, DOUBLE_MAX_WIDTH = 25 };
+
+static const char digit_pairs[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+/* Return the number of digits of V in BASE, which is 8, 10 or 16.  */
+
+int
+_obstack_count_digits (uintmax_t v, int base)
+{
+  int n = 1;
+
+  if (base == 10)
+    for (;;)
+      {
+        if (v < 10)
+          return n;
+        if (v < 100)
+          return n + 1;
+        if (v < 1000)
+          return n + 2;
+        if (v < 10000)
+          return n + 3;
+        v /= 10000;
+        n += 4;
+      }
+  while (v >>= (base == 16 ? 4 : 3))
+    n++;
+  return n;
+}
+
+/* Write V in BASE backwards, ending just before END, using uppercase
+   hexadecimal digits if UPPER.  */
+
+void
+_obstack_put_digits (char *end, uintmax_t v, int base, int upper)
+{
+  const char *xdigits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+
+  if (base == 10)
+    {
+      while (v >= 100)
+        {
+          end -= 2;
+          memcpy (end, digit_pairs + 2 * (v % 100), 2);
+          v /= 100;
+        }
+      if (v >= 10)
+        memcpy (end - 2, digit_pairs + 2 * v, 2);
+      else
+        end[-1] = '0' + v;
+    }
+  else
+    do
+      *--end = xdigits[v & (base - 1)];
+    while (v >>= (base == 16 ? 4 : 3));
+}
+
+/* Append the magnitude V in BASE, preceded by a minus sign if NEG, with
+   zeros inserted after the sign up to a total of WIDTH characters.  */
+
+static void
+grow_number (struct obstack *h, uint64_t v, int neg, int base, int width)
+{
+  int n = _obstack_count_digits (v, base);
+  int len = n + neg > width ? n + neg : width;
+  char *p;
+
+  obstack_make_room (h, len > U64_MAX_WIDTH ? len : U64_MAX_WIDTH);
+  p = obstack_next_free (h);
+  if (neg)
+    *p = '-';
+  memset (p + neg, '0', len - n - neg);
+  _obstack_put_digits (p + len, v, base, 0);
+  obstack_blank_fast (h, len);
+}
+
+void
+obstack_grow_u64 (struct obstack *h, uint64_t v)
+{
+  grow_number (h, v, 0, 10, 0);
+}
+
+void
+obstack_grow_i64 (struct obstack *h, int64_t v)
+{
+  grow_number (h, v < 0 ? -(uint64_t) v : (uint64_t) v, v < 0, 10, 0);
+}
+
+void
+obstack_grow_hex (struct obstack *h, uint64_t v)
+{
+  grow_number (h, v, 0, 16, 0);
+}
+
+void
+obstack_grow_u64_pad (struct obstack *h, uint64_t v, int width)
+{
+  grow_number (h, v, 0, 10, width);
+}
+
+void
+obstack_grow_i64_pad (struct obstack *h, int64_t v, int width)
+{
+  grow_number (h, v < 0 ? -(uint64_t) v : (uint64_t) v, v < 0, 10, width);
+}
+
+void
+obstack_grow_hex_pad (struct obstack *h, uint64_t v, int width)
+{
+  grow_number (h, v, 0, 16, width);
+}
+
+/* Shortest round-trip conversion of doubles, using Florian Loitsch's
+   Grisu2 algorithm.  The digits it produces always read back as the
+   same double, and are the shortest such digits in all but a tiny
+   fraction of cases, where one more digit than necessary is produced.  */
+
+/* A floating-point number F * 2^E with a 64-bit significand.  */
+
+struct diy_fp
+{
+  uint64_t f;
+  int e;
+};
+
+/* Normalized 10^K for K = -348, -340, ..., 340.  */
+
+static const uint64_t cached_powers_f[] =
+{
+  0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+  0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+  0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+  0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+  0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+  0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+  0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+  0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+  0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+  0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+  0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+  0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+  0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+  0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+  0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+  0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+  0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+  0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+  0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+  0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+  0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+  0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+  0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+  0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+  0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+  0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+  0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+  0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+  0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const short cached_powers_e[] =
+{
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+  -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+  -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+  -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+  -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+  109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+  641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+  907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t pow10_64[] =
+{
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+  1000000000, 10000000000, 100000000000, 1000000000000, 10000000000000,
+  100000000000000, 1000000000000000, 10000000000000000,
+  100000000000000000, 1000000000000000000, 10000000000000000000u
+};
+
+static struct diy_fp
+fp_mul (struct diy_fp x, struct diy_fp y)
+{
+  const uint64_t m32 = 0xFFFFFFFFu;
+  uint64_t a = x.f >> 32, b = x.f & m32, c = y.f >> 32, d = y.f & m32;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+  struct diy_fp r;
+
+  tmp += 1U << 31;              /* round */
+  r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+static struct diy_fp
+fp_normalize (struct diy_fp x)
+{
+  int s = __builtin_clzll (x.f);
+  x.f <<= s;
+  x.e -= s;
+  return x;
+}
+
+/* Return the cached power of ten that brings a number with binary
+   exponent E into the range Grisu works in, and set *K to minus its
+   decimal exponent.  */
+
+static struct diy_fp
+cached_power (int e, int *k)
+{
+  double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int ik = (int) dk;
+  unsigned index;
+  struct diy_fp r;
+
+  if (dk - ik > 0.0)
+    ik++;
+  index = (unsigned) ((ik >> 3) + 1);
+  *k = -(-348 + (int) (index << 3));
+  r.f = cached_powers_f[index];
+  r.e = cached_powers_e[index];
+  return r;
+}
+
+static void
+grisu_round (char *buf, int len, uint64_t delta, uint64_t rest,
+             uint64_t ten_kappa, uint64_t wp_w)
+{
+  while (rest < wp_w && delta - rest >= ten_kappa
+         && (rest + ten_kappa < wp_w
+             || wp_w - rest > rest + ten_kappa - wp_w))
+    {
+      buf[len - 1]--;
+      rest += ten_kappa;
+    }
+}
+
+/* Generate into BUF the digits of W, which lies within DELTA below MP,
+   set *LEN to their number and adjust the decimal exponent *K.  */
+
+static void
+digit_gen (struct diy_fp w, struct diy_fp mp, uint64_t delta,
+           char *buf, int *len, int *k)
+{
+  struct diy_fp one;
+  uint64_t wp_w = mp.f - w.f;
+  uint32_t p1;
+  uint64_t p2;
+  int kappa;
+
+  one.f = (uint64_t) 1 << -mp.e;
+  one.e = mp.e;
+  p1 = (uint32_t) (mp.f >> -one.e);
+  p2 = mp.f & (one.f - 1);
+  kappa = _obstack_count_digits (p1, 10);
+  *len = 0;
+
+  while (kappa > 0)
+    {
+      uint32_t d = p1 / (uint32_t) pow10_64[kappa - 1];
+      uint64_t tmp;
+
+      p1 %= (uint32_t) pow10_64[kappa - 1];
+      if (d || *len)
+        buf[(*len)++] = '0' + d;
+      kappa--;
+      tmp = ((uint64_t) p1 << -one.e) + p2;
+      if (tmp <= delta)
+        {
+          *k += kappa;
+          grisu_round (buf, *len, delta, tmp,
+                       pow10_64[kappa] << -one.e, wp_w);
+          return;
+        }
+    }
+
+  for (;;)
+    {
+      char d;
+
+      p2 *= 10;
+      delta *= 10;
+      d = (char) (p2 >> -one.e);
+      if (d || *len)
+        buf[(*len)++] = '0' + d;
+      p2 &= one.f - 1;
+      kappa--;
+      if (p2 < delta)
+        {
+          *k += kappa;
+          grisu_round (buf, *len, delta, p2, one.f,
+                       -kappa < 20 ? wp_w * pow10_64[-kappa] : 0);
+          return;
+        }
+    }
+}
+
+/* Write into BUF the shortest digits of the positive finite V, set *LEN
+   to their number and *K to the decimal exponent of the last one.  */
+
+static void
+grisu2 (double v, char *buf, int *len, int *k)
+{
+  const uint64_t hidden = (uint64_t) 1 << 52;
+  uint64_t bits;
+  struct diy_fp w, wp, wm, c;
+
+  memcpy (&bits, &v, sizeof bits);
+  w.f = bits & (hidden - 1);
+  w.e = (int) (bits >> 52 & 0x7FF);
+  if (w.e)
+    {
+      w.f += hidden;
+      w.e -= 1075;
+    }
+  else
+    w.e = -1074;
+
+  /* The boundaries halfway to the neighbouring doubles.  */
+  wp.f = (w.f << 1) + 1;
+  wp.e = w.e - 1;
+  while (!(wp.f & (hidden << 1)))
+    {
+      wp.f <<= 1;
+      wp.e--;
+    }
+  wp.f <<= 64 - 52 - 2;
+  wp.e -= 64 - 52 - 2;
+  if (w.f == hidden)
+    {
+      wm.f = (w.f << 2) - 1;
+      wm.e = w.e - 2;
+    }
+  else
+    {
+      wm.f = (w.f << 1) - 1;
+      wm.e = w.e - 1;
+    }
+  wm.f <<= wm.e - wp.e;
+  wm.e = wp.e;
+
+  c = cached_power (wp.e, k);
+  w = fp_mul (fp_normalize (w), c);
+  wp = fp_mul (wp, c);
+  wm = fp_mul (wm, c);
+  wm.f++;
+  wp.f--;
+  digit_gen (w, wp, wp.f - wm.f, buf, len, k);
+}
+
+/* Write the exponent K at P, returning the end.  */
+
+static char *
+write_exponent (char *p, int k)
+{
+  *p++ = 'e';
+  if (k < 0)
+    {
+      *p++ = '-';
+      k = -k;
+    }
+  else
+    *p++ = '+';
+  p += _obstack_count_digits (k, 10);
+  _obstack_put_digits (p, k, 10, 0);
+  return p;
+}
+
+/* Lay out the LEN digits at BUF, whose last has decimal exponent K, in
+   positional or exponential notation as JavaScript does, and return the
+   end.  BUF must have room for DOUBLE_MAX_WIDTH characters.  */
+
+static char *
+prettify (char *buf, int len, int k)
+{
+  int kk = len + k;             /* 10^(kk-1) <= v < 10^kk */
+
+  if (len <= kk && kk <= 21)
+    {
+      /* 1234e7 -> 12340000000 */
+      memset (buf + len, '0', kk - len);
+      return buf + kk;
+    }
+  if (0 < kk && kk <= 21)
+    {
+      /* 1234e-2 -> 12.34 */
+      memmove (buf + kk + 1, buf + kk, len - kk);
+      buf[kk] = '.';
+      return buf + len + 1;
+    }
+  if (-6 < kk && kk <= 0)
+    {
+      /* 1234e-6 -> 0.001234 */
+      int offset = 2 - kk;
+      memmove (buf + offset, buf, len);
+      buf[0] = '0';
+      buf[1] = '.';
+      memset (buf + 2, '0', offset - 2);
+      return buf + len + offset;
+    }
+  if (len == 1)
+    /* 1e30 */
+    return write_exponent (buf + 1, kk - 1);
+  /* 1234e30 -> 1.234e+33 */
+  memmove (buf + 2, buf + 1, len - 1);
+  buf[1] = '.';
+  return write_exponent (buf + len + 1, kk - 1);
+}
+
+/* Append V in the shortest form that reads back as V, in the notation
+   JavaScript uses: positional for magnitudes from 1e-6 up to 1e21 and
+   exponential otherwise.  Infinities and NaNs come out as "inf", "-inf"
+   and "nan".  */
+
+void
+obstack_grow_double (struct obstack *h, double v)
+{
+  char *p, *end;
+  int len, k;
+
+  obstack_make_room (h, DOUBLE_MAX_WIDTH);
+  p = obstack_next_free (h);
+  if (v != v)
+    {
+      memcpy (p, "nan", 3);
+      end = p + 3;
+    }
+  else
+    {
+      if (__builtin_signbit (v))
+        {
+          *p++ = '-';
+          v = -v;
+        }
+      if (v == 0)
+        {
+          *p = '0';
+          end = p + 1;
+        }
+      else if (v > 1.7976931348623157e308)
+        {
+          memcpy (p, "inf", 3);
+          end = p + 3;
+        }
+      else
+        {
+          grisu2 (v, p, &len, &k);
+          end = prettify (p, len, k);
+        }
+    }
+  obstack_blank_fast (h, end - (char *) obstack_next_free (h));
+}
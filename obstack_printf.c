@@ -23,14 +23,332 @@
 // #include "vasnprintf.h"
 
 #include <errno.h>
+#include <limits.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* The common conversions are formatted here, directly into the room of
+   the obstack, without going through the stdio machinery behind
+   vsnprintf.  Everything else, notably floating point, is left to
+   vsnprintf.  */
+
+/* Returned by format_native for a format it does not handle.  */
+enum { FALLBACK = -2 };
+
+/* Flags of a conversion specification.  */
+enum
+{
+  FL_LEFT = 1,                  /* '-' */
+  FL_PLUS = 2,                  /* '+' */
+  FL_SPACE = 4,                 /* ' ' */
+  FL_ALT = 8,                   /* '#' */
+  FL_ZERO = 16                  /* '0' */
+};
+
+/* Append the integer of magnitude V, negative if NEG, formatted as for
+   a conversion in BASE with FLAGS, WIDTH and PRECISION (negative if
+   none).  SIGNED_CONV is nonzero for %d and %i.  */
+
+static void
+put_int (struct obstack *obs, uintmax_t v, int neg, int signed_conv,
+         int base, int upper, int flags, int width, int precision)
+{
+  char prefix[2];
+  int nprefix = 0;
+  int ndigits = ((precision == 0 && v == 0)
+                 ? 0 : _obstack_count_digits (v, base));
+  int zeros = precision > ndigits ? precision - ndigits : 0;
+  int pad;
+  size_t total;
+  char *p;
+
+  if (signed_conv)
+    {
+      if (neg)
+        prefix[nprefix++] = '-';
+      else if (flags & FL_PLUS)
+        prefix[nprefix++] = '+';
+      else if (flags & FL_SPACE)
+        prefix[nprefix++] = ' ';
+    }
+  else if (flags & FL_ALT)
+    {
+      if (base == 16 && v != 0)
+        {
+          prefix[nprefix++] = '0';
+          prefix[nprefix++] = upper ? 'X' : 'x';
+        }
+      else if (base == 8 && zeros == 0 && (ndigits == 0 || v != 0))
+        zeros = 1;
+    }
+
+  total = (size_t) nprefix + zeros + ndigits;
+  pad = (size_t) width > total ? width - (int) total : 0;
+  if ((flags & (FL_ZERO | FL_LEFT)) == FL_ZERO && precision < 0)
+    {
+      zeros += pad;
+      pad = 0;
+    }
+
+  obstack_make_room (obs, (size_t) nprefix + zeros + ndigits + pad);
+  p = obstack_next_free (obs);
+  if (!(flags & FL_LEFT))
+    {
+      memset (p, ' ', pad);
+      p += pad;
+    }
+  memcpy (p, prefix, nprefix);
+  p += nprefix;
+  memset (p, '0', zeros);
+  p += zeros + ndigits;
+  if (ndigits)
+    _obstack_put_digits (p, v, base, upper);
+  if (flags & FL_LEFT)
+    {
+      memset (p, ' ', pad);
+      p += pad;
+    }
+  obstack_blank_fast (obs, p - (char *) obstack_next_free (obs));
+}
+
+/* Append S, of length LEN, padded to WIDTH as FLAGS say.  */
+
+static void
+put_padded (struct obstack *obs, const char *s, size_t len,
+            int flags, int width)
+{
+  size_t pad = (size_t) width > len ? width - len : 0;
+  char *p;
+
+  obstack_make_room (obs, len + pad);
+  p = obstack_next_free (obs);
+  if (!(flags & FL_LEFT))
+    {
+      memset (p, ' ', pad);
+      p += pad;
+    }
+  memcpy (p, s, len);
+  p += len;
+  if (flags & FL_LEFT)
+    {
+      memset (p, ' ', pad);
+      p += pad;
+    }
+  obstack_blank_fast (obs, len + pad);
+}
+
+/* Grow OBS with FORMAT formatted with the arguments AP points to, and
+   return the number of bytes added.  Return FALLBACK, leaving OBS as it
+   was, if FORMAT has a conversion this does not handle.  */
+
+static int
+format_native (struct obstack *obs, const char *format, va_list *ap)
+{
+  _OBSTACK_SIZE_T start = obstack_object_size (obs);
+  const char *f = format;
+  size_t len;
+
+  for (;;)
+    {
+      const char *pct = strchr (f, '%');
+      int flags = 0, width = 0, precision = -1;
+      enum { L_INT, L_CHAR, L_SHORT, L_LONG, L_LLONG, L_SIZE, L_INTMAX,
+             L_PTRDIFF } lmod = L_INT;
+      uintmax_t v;
+      int neg = 0;
+
+      len = pct ? (size_t) (pct - f) : strlen (f);
+      if (len)
+        obstack_grow (obs, f, len);
+      if (!pct)
+        break;
+      f = pct + 1;
+
+      for (;; f++)
+        {
+          if (*f == '-')
+            flags |= FL_LEFT;
+          else if (*f == '+')
+            flags |= FL_PLUS;
+          else if (*f == ' ')
+            flags |= FL_SPACE;
+          else if (*f == '#')
+            flags |= FL_ALT;
+          else if (*f == '0')
+            flags |= FL_ZERO;
+          else
+            break;
+        }
+
+      if (*f == '*')
+        {
+          width = va_arg (*ap, int);
+          if (width < 0)
+            {
+              flags |= FL_LEFT;
+              width = width == INT_MIN ? INT_MAX : -width;
+            }
+          f++;
+        }
+      else
+        for (; '0' <= *f && *f <= '9'; f++)
+          {
+            if (width > (INT_MAX - 9) / 10)
+              goto fallback;
+            width = width * 10 + (*f - '0');
+          }
+      if (*f == '$')
+        /* Positional arguments.  */
+        goto fallback;
+
+      if (*f == '.')
+        {
+          f++;
+          precision = 0;
+          if (*f == '*')
+            {
+              precision = va_arg (*ap, int);
+              if (precision < 0)
+                precision = -1;
+              f++;
+            }
+          else
+            for (; '0' <= *f && *f <= '9'; f++)
+              {
+                if (precision > (INT_MAX - 9) / 10)
+                  goto fallback;
+                precision = precision * 10 + (*f - '0');
+              }
+        }
+
+      switch (*f)
+        {
+        case 'h':
+          lmod = f[1] == 'h' ? (f++, L_CHAR) : L_SHORT;
+          f++;
+          break;
+        case 'l':
+          lmod = f[1] == 'l' ? (f++, L_LLONG) : L_LONG;
+          f++;
+          break;
+        case 'z':
+          lmod = L_SIZE;
+          f++;
+          break;
+        case 'j':
+          lmod = L_INTMAX;
+          f++;
+          break;
+        case 't':
+          lmod = L_PTRDIFF;
+          f++;
+          break;
+        }
+
+      switch (*f++)
+        {
+        case 'd':
+        case 'i':
+          {
+            intmax_t i;
+            switch (lmod)
+              {
+              case L_CHAR: i = (signed char) va_arg (*ap, int); break;
+              case L_SHORT: i = (short) va_arg (*ap, int); break;
+              case L_LONG: i = va_arg (*ap, long); break;
+              case L_LLONG: i = va_arg (*ap, long long); break;
+              case L_SIZE: i = va_arg (*ap, ptrdiff_t); break;
+              case L_INTMAX: i = va_arg (*ap, intmax_t); break;
+              case L_PTRDIFF: i = va_arg (*ap, ptrdiff_t); break;
+              default: i = va_arg (*ap, int); break;
+              }
+            neg = i < 0;
+            v = neg ? -(uintmax_t) i : (uintmax_t) i;
+            put_int (obs, v, neg, 1, 10, 0, flags, width, precision);
+          }
+          break;
+
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+          switch (lmod)
+            {
+            case L_CHAR: v = (unsigned char) va_arg (*ap, unsigned int); break;
+            case L_SHORT: v = (unsigned short) va_arg (*ap, unsigned int); break;
+            case L_LONG: v = va_arg (*ap, unsigned long); break;
+            case L_LLONG: v = va_arg (*ap, unsigned long long); break;
+            case L_SIZE: v = va_arg (*ap, size_t); break;
+            case L_INTMAX: v = va_arg (*ap, uintmax_t); break;
+            case L_PTRDIFF: v = va_arg (*ap, size_t); break;
+            default: v = va_arg (*ap, unsigned int); break;
+            }
+          put_int (obs, v, 0, 0,
+                   f[-1] == 'u' ? 10 : f[-1] == 'o' ? 8 : 16, f[-1] == 'X',
+                   flags, width, precision);
+          break;
+
+        case 'p':
+          /* Printed as %#x would print it, except that a null pointer
+             and flags other than '-' are left to vsnprintf.  */
+          v = (uintptr_t) va_arg (*ap, void *);
+          if (v == 0 || (flags & ~FL_LEFT))
+            goto fallback;
+          put_int (obs, v, 0, 0, 16, 0, flags | FL_ALT, width, precision);
+          break;
+
+        case 'c':
+          if (lmod != L_INT)
+            goto fallback;
+          {
+            char c = (unsigned char) va_arg (*ap, int);
+            put_padded (obs, &c, 1, flags, width);
+          }
+          break;
+
+        case 's':
+          if (lmod != L_INT)
+            goto fallback;
+          {
+            const char *s = va_arg (*ap, const char *);
+            if (!s)
+              s = "(null)";
+            put_padded (obs, s, precision < 0 ? strlen (s)
+                                  : strnlen (s, precision), flags, width);
+          }
+          break;
+
+        case '%':
+          obstack_1grow (obs, '%');
+          break;
+
+        default:
+          goto fallback;
+        }
+    }
+
+  len = obstack_object_size (obs) - start;
+  if (len > INT_MAX)
+    {
+      obs->next_free = obs->object_base + start;
+      errno = EOVERFLOW;
+      return -1;
+    }
+  return len;
+
+ fallback:
+  obs->next_free = obs->object_base + start;
+  return FALLBACK;
+}
 
 /* Grow an obstack with formatted output.  Return the number of bytes
    added to OBS.  No trailing nul byte is added, and the object should
    be closed with obstack_finish before use.
 
-   Upon memory allocation error, call obstack_alloc_failed_handler.
+   Upon memory allocation error, call the failed handler of OBS.
    Upon other error, return -1.  */
 int
 obstack_printf (struct obstack *obs, const char *format, ...)
@@ -48,41 +366,44 @@ obstack_printf (struct obstack *obs, const char *format, ...)
    added to OBS.  No trailing nul byte is added, and the object should
    be closed with obstack_finish before use.
 
-   Upon memory allocation error, call obstack_alloc_failed_handler.
+   Upon memory allocation error, call the failed handler of OBS.
    Upon other error, return -1.  */
 int
 obstack_vprintf (struct obstack *obs, const char *format, va_list args)
 {
-  /* If we are close to the end of the current obstack chunk, use a
-     stack-allocated buffer and copy, to reduce the likelihood of a
-     small-size malloc.  Otherwise, print directly into the
-     obstack.  */
-  enum { CUTOFF = 1024 };
-  char buf[CUTOFF];
-  char *base = obstack_next_free (obs);
-  size_t len = obstack_room (obs);
-
-  if (len < CUTOFF)
+  /* Formats with only common conversions are handled by format_native.
+     Otherwise print directly into the room left in the current chunk.
+     If the output does not fit, that first pass still tells its exact
+     length, so make exactly that much room and print once more,
+     straight into the obstack.  The room includes space for the
+     trailing nul that vsnprintf writes, which is not counted as part of
+     the object.  */
+  _OBSTACK_SIZE_T room;
+  va_list args_copy;
+  int len;
+
+  va_copy (args_copy, args);
+  len = format_native (obs, format, &args_copy);
+  va_end (args_copy);
+  if (len != FALLBACK)
+    return len;
+
+  room = obstack_room (obs);
+  va_copy (args_copy, args);
+  len = vsnprintf (obstack_next_free (obs), room, format, args_copy);
+  va_end (args_copy);
+  if (len >= 0 && (size_t) len >= room)
     {
-      base = buf;
-      len = CUTOFF;
+      obstack_make_room (obs, (size_t) len + 1);
+      len = vsnprintf (obstack_next_free (obs), (size_t) len + 1,
+                       format, args);
     }
-  len = vsnprintf (base, len, format, args);
   if (len < 0)
     {
       if (errno == ENOMEM)
-        obstack_alloc_failed_handler ();
+        _obstack_alloc_failed (obs);
       return -1;
     }
-  if (base != buf)
-    /* The output was already computed in place, but we need to
-       account for its size.  */
-    obstack_blank_fast (obs, len);
-  else
-    {
-      /* We used buf;
-         copy the resulting string.  */
-      obstack_grow (obs, base, len);
-    }
+  obstack_blank_fast (obs, len);
   return len;
 }
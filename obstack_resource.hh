@@ -0,0 +1,118 @@
+/* obstack_resource.hh - std::pmr::memory_resource over an obstack
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   ObstackResource lets the pmr containers of C++17 allocate from an
+   obstack:
+
+        struct obstack ob;
+        obstack_init (&ob);
+        {
+          gnulib::ObstackResource res (&ob);
+          std::pmr::vector<int> v (&res);
+          std::pmr::unordered_map<int, std::pmr::string> m (&res);
+          ...
+        }
+        obstack_free (&ob, NULL);
+
+   Allocation is an obstack_alloc, rounded up for alignments stricter
+   than the obstack's own.  Deallocation does nothing unless the block is
+   the last object in the obstack, in which case the obstack is rewound
+   to it, so that a container freeing its most recent allocation gives
+   the space back.  Everything else is reclaimed when the obstack is
+   freed, which must not happen while a container still uses it.
+
+   Allocation failure throws std::bad_alloc instead of calling the
+   obstack's failure handler.  The resource must not be used while an
+   object is growing in the obstack, since each allocation finishes the
+   current object.  */
+
+#ifndef _OBSTACK_RESOURCE_HH
+#define _OBSTACK_RESOURCE_HH 1
+
+#include "obstack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace gnulib
+{
+
+class ObstackResource : public std::pmr::memory_resource
+{
+public:
+  explicit ObstackResource (struct obstack *h) noexcept : h_ (h) {}
+
+  ObstackResource (const ObstackResource &) = delete;
+  ObstackResource &operator= (const ObstackResource &) = delete;
+
+  struct obstack *obstack () const noexcept { return h_; }
+
+protected:
+  void *
+  do_allocate (std::size_t bytes, std::size_t align) override
+  {
+    std::size_t slack = align > alignment () ? align - alignment () : 0;
+    void *p;
+
+    if (bytes > (_OBSTACK_SIZE_T) -1 - slack
+        || !(p = obstack_try_alloc (h_, bytes + slack)))
+      throw std::bad_alloc ();
+    if (slack)
+      p = (void *) (((std::uintptr_t) p + align - 1)
+                    & ~(std::uintptr_t) (align - 1));
+    return p;
+  }
+
+  void
+  do_deallocate (void *p, std::size_t bytes, std::size_t align) override
+  {
+    /* An over-aligned block may not start where its object does.  */
+    if (align <= alignment () && obstack_object_size (h_) == 0
+        && end_of (p, bytes) == obstack_next_free (h_))
+      obstack_free (h_, p);
+  }
+
+  bool
+  do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+  {
+    const ObstackResource *o = dynamic_cast<const ObstackResource *> (&other);
+    return o && o->h_ == h_;
+  }
+
+private:
+  std::size_t alignment () const noexcept
+  {
+    return obstack_alignment_mask (h_) + 1;
+  }
+
+  /* Where obstack_alloc would have put the next object after a block
+     of BYTES at P.  */
+  void *end_of (void *p, std::size_t bytes) const noexcept
+  {
+    std::uintptr_t mask = obstack_alignment_mask (h_);
+    return (void *) (((std::uintptr_t) p + bytes + mask) & ~mask);
+  }
+
+  struct obstack *h_;
+};
+
+}       /* namespace gnulib */
+
+#endif /* _OBSTACK_RESOURCE_HH */
@@ -0,0 +1,56 @@
+/* obstack_stream.c - stdio streams that write into obstacks
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE 1          /* for fopencookie */
+#endif
+
+/* Specification.  */
+#include "obstack.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+static ssize_t
+stream_write (void *cookie, const char *buf, size_t size)
+{
+  if (!obstack_try_grow ((struct obstack *) cookie, buf, size))
+    {
+      errno = ENOMEM;
+      return 0;
+    }
+  return size;
+}
+
+/* Return a stream whose output is appended to the object growing in H,
+   or NULL if the stream cannot be created.  The stream is unbuffered,
+   so that stdio hands each write straight to the obstack and the bytes
+   are copied once; output may be interleaved freely with the obstack
+   macros.  A write for which H cannot get memory fails with ENOMEM,
+   setting the stream's error indicator, rather than calling the failed
+   handler.  Closing the stream does not touch H.  */
+
+FILE *
+obstack_open_stream (struct obstack *h)
+{
+  cookie_io_functions_t io = { NULL, stream_write, NULL, NULL };
+  FILE *f = fopencookie (h, "w", io);
+
+  if (f)
+    setvbuf (f, NULL, _IONBF, 0);
+  return f;
+}
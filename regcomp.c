@@ -1,50 +1,2808 @@
-<?xml version="1.0" encoding="utf-8"?>
-<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Strict//EN" "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd">
-<html xmlns="http://www.w3.org/1999/xhtml" xml:lang="en-US" lang="en-US">
-<!-- git web interface version 2.17.1, (C) 2005-2006, Kay Sievers <kay.sievers@vrfy.org>, Christian Gierke -->
-<!-- git core binaries version 2.17.1 -->
-<head>
-<meta http-equiv="content-type" content="text/html; charset=utf-8"/>
-<meta name="generator" content="gitweb/2.17.1 git/2.17.1"/>
-<meta name="robots" content="index, nofollow"/>
-<title>Savannah Git Hosting - gnulib.git/blob_plain - lib/$f</title>
-<link rel="stylesheet" type="text/css" href="/gitweb/static/gitweb.css"/>
-<link rel="shortcut icon" href="/gitweb/static/git-favicon.png" type="image/png" />
-</head>
-<body>
-<div class="page_header">
-<a href="http://git-scm.com/" title="git homepage"><img alt="git" class="logo" height="27" src="/gitweb/static/git-logo.png" width="72" /></a><a href="/gitweb/">git@sv</a> / <a href="/gitweb/?p=gnulib.git;a=summary">gnulib.git</a> / blob_plain
-</div>
-<form method="get" action="/gitweb/" enctype="multipart/form-data"><div class="search">
-<input name="p" type="hidden" value="gnulib.git" />
-<input name="a" type="hidden" value="search" />
-<input name="h" type="hidden" value="HEAD" />
-<select name="st" >
-<option selected="selected" value="commit">commit</option>
-<option value="grep">grep</option>
-<option value="author">author</option>
-<option value="committer">committer</option>
-<option value="pickaxe">pickaxe</option>
-</select> <a href="/gitweb/?p=gnulib.git;a=search_help" title="search help">?</a> search:
-<input type="text" name="s"  />
-<span title="Extended regular expression"><label><input type="checkbox" name="sr" value="1" />re</label></span></div>
-</form>
-<div class="page_body">
-<br /><br />
-404 - Cannot find file
-<br />
-</div>
-<div class="page_footer">
-<div class="page_footer_text">gnulib - GNU portability library</div>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=rss;f=lib/%24f" title="history of lib/$f RSS feed">RSS</a>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=atom;f=lib/%24f" title="history of lib/$f Atom feed">Atom</a>
-</div>
-<script type="text/javascript" src="/gitweb/static/gitweb.js"></script>
-<script type="text/javascript">
-window.onload = function () {
-	var tz_cookie = { name: 'gitweb_tz', expires: 14, path: '/' };
-	onloadTZSetup('local', tz_cookie, 'datetime');
-};
-</script>
-</body>
-</html>
\ No newline at end of file
+/* Extended regular expression matching and search library.
+   Copyright (C) 2002-2023 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* The pattern is parsed into a tree, and the tree compiled into a
+   program for a Thompson NFA: instructions that each consume one byte
+   of a set, or step to other instructions without consuming anything.
+   regexec.c runs the program through a DFA built lazily from it.  A
+   second program, compiled from the tree with every concatenation
+   reversed, lets the matcher find where a match starts once it knows
+   where the match ends.  */
+
+static reg_errcode_t re_compile_internal (regex_t *preg, const char * pattern,
+					  size_t length, reg_syntax_t syntax);
+static reg_errcode_t re_compile_set (regex_t *preg,
+				     const char *const *patterns,
+				     size_t npatterns, reg_syntax_t syntax,
+				     int cflags, size_t *failed);
+static reg_errcode_t re_prepare_buffer (regex_t *preg, reg_syntax_t syntax);
+static reg_errcode_t init_dfa (re_dfa_t *dfa, const regex_t *preg,
+			       reg_syntax_t syntax);
+static void free_dfa_content (re_dfa_t *dfa);
+static bin_tree_t *parse (re_string_t *regexp, regex_t *preg,
+			  reg_syntax_t syntax, reg_errcode_t *err);
+static bin_tree_t *parse_reg_exp (re_string_t *regexp, regex_t *preg,
+				  re_token_t *token, reg_syntax_t syntax,
+				  Idx nest, reg_errcode_t *err);
+static bin_tree_t *parse_branch (re_string_t *regexp, regex_t *preg,
+				 re_token_t *token, reg_syntax_t syntax,
+				 Idx nest, reg_errcode_t *err);
+static bin_tree_t *parse_expression (re_string_t *regexp, regex_t *preg,
+				     re_token_t *token, reg_syntax_t syntax,
+				     Idx nest, reg_errcode_t *err);
+static bin_tree_t *parse_sub_exp (re_string_t *regexp, regex_t *preg,
+				  re_token_t *token, reg_syntax_t syntax,
+				  Idx nest, reg_errcode_t *err);
+static bin_tree_t *parse_dup_op (bin_tree_t *dup_elem, re_string_t *regexp,
+				 re_dfa_t *dfa, re_token_t *token,
+				 reg_syntax_t syntax, reg_errcode_t *err);
+static bin_tree_t *parse_bracket_exp (re_string_t *regexp, re_dfa_t *dfa,
+				      re_token_t *token, reg_syntax_t syntax,
+				      reg_errcode_t *err);
+static reg_errcode_t parse_bracket_element (bracket_elem_t *elem,
+					    re_string_t *regexp,
+					    re_token_t *token, int token_len,
+					    reg_syntax_t syntax,
+					    bool accept_hyphen);
+static reg_errcode_t parse_bracket_symbol (bracket_elem_t *elem,
+					   re_string_t *regexp,
+					   re_token_t *token);
+static Idx fetch_number (re_string_t *input, re_token_t *token,
+			 reg_syntax_t syntax);
+static int peek_token (re_token_t *token, re_string_t *input,
+			reg_syntax_t syntax);
+static int peek_token_bracket (re_token_t *token, re_string_t *input,
+			       reg_syntax_t syntax);
+static reg_errcode_t build_range_exp (bitset_t sbcset, reg_syntax_t syntax,
+				      bracket_elem_t *start_elem,
+				      bracket_elem_t *end_elem);
+static reg_errcode_t build_charclass (const unsigned char *trans,
+				      bitset_t sbcset,
+				      const char *class_name,
+				      reg_syntax_t syntax);
+static bin_tree_t *build_charclass_op (re_dfa_t *dfa,
+				       const unsigned char *trans,
+				       const char *class_name,
+				       const char *extra,
+				       bool non_match, reg_errcode_t *err);
+static bin_tree_t *create_tree (re_dfa_t *dfa,
+				bin_tree_t *left, bin_tree_t *right,
+				re_token_type_t type);
+static bin_tree_t *create_token_tree (re_dfa_t *dfa,
+				      bin_tree_t *left, bin_tree_t *right,
+				      const re_token_t *token);
+static Idx new_sbcset (re_dfa_t *dfa);
+static reg_errcode_t compile_progs (re_dfa_t *dfa, const bin_tree_t *tree);
+static reg_errcode_t compile_set_prog (re_dfa_t *dfa,
+				       bin_tree_t *const *trees, Idx ntrees);
+static void calc_first (re_dfa_t *dfa);
+static void calc_must (re_dfa_t *dfa, const bin_tree_t *tree);
+static void re_dfa_set_context (re_dfa_t *dfa, bool newline_anchor);
+
+/* This table gives an error message for each of the error codes listed
+   in regex.h.  Obviously the order here has to be same as there.
+   POSIX doesn't require that we do anything for REG_NOERROR,
+   but why not be nice?  */
+
+static const char __re_error_msgid[] =
+  {
+#define REG_NOERROR_IDX	0
+    gettext_noop ("Success")	/* REG_NOERROR */
+    "\0"
+#define REG_NOMATCH_IDX (REG_NOERROR_IDX + sizeof "Success")
+    gettext_noop ("No match")	/* REG_NOMATCH */
+    "\0"
+#define REG_BADPAT_IDX	(REG_NOMATCH_IDX + sizeof "No match")
+    gettext_noop ("Invalid regular expression") /* REG_BADPAT */
+    "\0"
+#define REG_ECOLLATE_IDX (REG_BADPAT_IDX + sizeof "Invalid regular expression")
+    gettext_noop ("Invalid collation character") /* REG_ECOLLATE */
+    "\0"
+#define REG_ECTYPE_IDX	(REG_ECOLLATE_IDX + sizeof "Invalid collation character")
+    gettext_noop ("Invalid character class name") /* REG_ECTYPE */
+    "\0"
+#define REG_EESCAPE_IDX	(REG_ECTYPE_IDX + sizeof "Invalid character class name")
+    gettext_noop ("Trailing backslash") /* REG_EESCAPE */
+    "\0"
+#define REG_ESUBREG_IDX	(REG_EESCAPE_IDX + sizeof "Trailing backslash")
+    gettext_noop ("Invalid back reference") /* REG_ESUBREG */
+    "\0"
+#define REG_EBRACK_IDX	(REG_ESUBREG_IDX + sizeof "Invalid back reference")
+    gettext_noop ("Unmatched [, [^, [:, [., or [=")	/* REG_EBRACK */
+    "\0"
+#define REG_EPAREN_IDX	(REG_EBRACK_IDX + sizeof "Unmatched [, [^, [:, [., or [=")
+    gettext_noop ("Unmatched ( or \\(") /* REG_EPAREN */
+    "\0"
+#define REG_EBRACE_IDX	(REG_EPAREN_IDX + sizeof "Unmatched ( or \\(")
+    gettext_noop ("Unmatched \\{") /* REG_EBRACE */
+    "\0"
+#define REG_BADBR_IDX	(REG_EBRACE_IDX + sizeof "Unmatched \\{")
+    gettext_noop ("Invalid content of \\{\\}") /* REG_BADBR */
+    "\0"
+#define REG_ERANGE_IDX	(REG_BADBR_IDX + sizeof "Invalid content of \\{\\}")
+    gettext_noop ("Invalid range end")	/* REG_ERANGE */
+    "\0"
+#define REG_ESPACE_IDX	(REG_ERANGE_IDX + sizeof "Invalid range end")
+    gettext_noop ("Memory exhausted") /* REG_ESPACE */
+    "\0"
+#define REG_BADRPT_IDX	(REG_ESPACE_IDX + sizeof "Memory exhausted")
+    gettext_noop ("Invalid preceding regular expression") /* REG_BADRPT */
+    "\0"
+#define REG_EEND_IDX	(REG_BADRPT_IDX + sizeof "Invalid preceding regular expression")
+    gettext_noop ("Premature end of regular expression") /* REG_EEND */
+    "\0"
+#define REG_ESIZE_IDX	(REG_EEND_IDX + sizeof "Premature end of regular expression")
+    gettext_noop ("Regular expression too big") /* REG_ESIZE */
+    "\0"
+#define REG_ERPAREN_IDX	(REG_ESIZE_IDX + sizeof "Regular expression too big")
+    gettext_noop ("Unmatched ) or \\)") /* REG_ERPAREN */
+  };
+
+static const size_t __re_error_msgid_idx[] =
+  {
+    REG_NOERROR_IDX,
+    REG_NOMATCH_IDX,
+    REG_BADPAT_IDX,
+    REG_ECOLLATE_IDX,
+    REG_ECTYPE_IDX,
+    REG_EESCAPE_IDX,
+    REG_ESUBREG_IDX,
+    REG_EBRACK_IDX,
+    REG_EPAREN_IDX,
+    REG_EBRACE_IDX,
+    REG_BADBR_IDX,
+    REG_ERANGE_IDX,
+    REG_ESPACE_IDX,
+    REG_BADRPT_IDX,
+    REG_EEND_IDX,
+    REG_ESIZE_IDX,
+    REG_ERPAREN_IDX
+  };
+
+/* Entry points for GNU code.  */
+
+/* re_compile_pattern is the GNU regular expression compiler: it
+   compiles PATTERN (of length LENGTH) and puts the result in BUFP.
+   Returns 0 if the pattern was valid, otherwise an error string.
+
+   Assumes the 'allocated' (and perhaps 'buffer') and 'translate' fields
+   are set in BUFP on entry.  */
+
+const char *
+re_compile_pattern (const char *pattern, size_t length,
+		    struct re_pattern_buffer *bufp)
+{
+  reg_errcode_t ret;
+
+  /* And GNU code determines whether or not to get register information
+     by passing null for the REGS argument to re_match, etc., not by
+     setting no_sub, unless RE_NO_SUB is set.  */
+  bufp->no_sub = !!(re_syntax_options & RE_NO_SUB);
+
+  /* Match anchors at newline.  */
+  bufp->newline_anchor = 1;
+
+  ret = re_compile_internal (bufp, pattern, length, re_syntax_options);
+
+  if (!ret)
+    return NULL;
+  return gettext (__re_error_msgid + __re_error_msgid_idx[(int) ret]);
+}
+
+/* Set by 're_set_syntax' to the current regexp syntax to recognize.  Can
+   also be assigned to arbitrarily: each pattern buffer stores its own
+   syntax, so it can be changed between regex compilations.  */
+/* This has no initializer because initialized variables in Emacs
+   become read-only after dumping.  */
+reg_syntax_t re_syntax_options;
+
+
+/* Specify the precise syntax of regexps for compilation.  This provides
+   for compatibility for various utilities which historically have
+   different, incompatible syntaxes.
+
+   The argument SYNTAX is a bit mask comprised of the various bits
+   defined in regex.h.  We return the old syntax.  */
+
+reg_syntax_t
+re_set_syntax (reg_syntax_t syntax)
+{
+  reg_syntax_t ret = re_syntax_options;
+
+  re_syntax_options = syntax;
+  return ret;
+}
+
+/* Fill in the fastmap of BUFP: a nonzero byte for each byte a match
+   can start with.  The matcher does not need it, but GNU code may look
+   at it.  */
+
+int
+re_compile_fastmap (struct re_pattern_buffer *bufp)
+{
+  re_dfa_t *dfa = bufp->buffer;
+  char *fastmap = bufp->fastmap;
+  int i;
+
+  if (fastmap == NULL)
+    return 0;
+  for (i = 0; i < SBC_MAX; ++i)
+    fastmap[i] = bitset_contain (dfa->firstset, i);
+  bufp->can_be_null = dfa->can_be_null;
+  bufp->fastmap_accurate = 1;
+  return 0;
+}
+
+/* Helper function for re_compile_fastmap.
+   Compute the set of bytes a match can start with, and whether a match
+   can be empty, by following the program from its entry; anchors are
+   assumed to hold.  Make up the set to look for those bytes with.  */
+
+static void
+calc_first (re_dfa_t *dfa)
+{
+  re_prog_t *prog = &dfa->fwd;
+  Idx *stack = prog->stack;
+  Idx sp = 0;
+  int ch;
+
+  bitset_empty (dfa->firstset);
+  dfa->can_be_null = false;
+  prog->nvisited = 0;
+  stack[sp++] = 0;
+  while (sp > 0)
+    {
+      Idx pc = stack[--sp];
+      const re_inst_t *inst = &prog->insts[pc];
+
+      if (!re_prog_visit (prog, pc))
+	continue;
+      switch (inst->opcode)
+	{
+	case INST_CHARSET:
+	  bitset_merge (dfa->firstset, dfa->sbcsets[inst->arg]);
+	  break;
+	case INST_ALT:
+	  stack[sp++] = inst->y;
+	  stack[sp++] = inst->x;
+	  break;
+	case INST_JMP:
+	  stack[sp++] = inst->x;
+	  break;
+	case INST_BACKREF:
+	  /* The subexpression may have matched anything.  */
+	  bitset_set_all (dfa->firstset);
+	  FALLTHROUGH;
+	case INST_SAVE:
+	case INST_ANCHOR:
+	  stack[sp++] = pc + 1;
+	  break;
+	case INST_MATCH:
+	  dfa->can_be_null = true;
+	  break;
+	}
+    }
+
+  simd_byteset_init (&dfa->first_scan);
+  for (ch = 0; ch < SBC_MAX; ch++)
+    if (bitset_contain (dfa->firstset, ch))
+      simd_byteset_add (&dfa->first_scan, ch);
+}
+
+/* Entry point for POSIX code.  */
+
+/* regcomp takes a regular expression as a string and compiles it.
+
+   PREG is a regex_t *.  We do not expect any fields to be initialized,
+   since POSIX says we shouldn't.  Thus, we set
+
+     'buffer' to the compiled pattern;
+     'used' to the length of the compiled pattern;
+     'syntax' to RE_SYNTAX_POSIX_EXTENDED if the
+       REG_EXTENDED bit in CFLAGS is set; otherwise, to
+       RE_SYNTAX_POSIX_BASIC;
+     'newline_anchor' to REG_NEWLINE being set in CFLAGS;
+     'fastmap' to an allocated space for the fastmap;
+     'fastmap_accurate' to zero;
+     're_nsub' to the number of subexpressions in PATTERN.
+
+   PATTERN is the address of the pattern string.
+
+   CFLAGS is a series of bits which affect compilation.
+
+     If REG_EXTENDED is set, we use POSIX extended syntax; otherwise, we
+     use POSIX basic syntax.
+
+     If REG_NEWLINE is set, then . and [^...] don't match newline.
+     Also, regexec will try a match beginning after every newline.
+
+     If REG_ICASE is set, then we considers upper- and lowercase
+     versions of letters to be equivalent when matching.
+
+     If REG_NOSUB is set, then when PREG is passed to regexec, that
+     routine will report only success or failure, and nothing about the
+     registers.
+
+     If REG_EARLIEST is set, then regexec reports the match that ends
+     first rather than the leftmost-longest one.
+
+   It returns 0 if it succeeds, nonzero if it doesn't.  (See regex.h for
+   the return codes and their meanings.)  */
+
+/* Return the syntax 'regcomp' compiles with for CFLAGS.  */
+
+static reg_syntax_t
+posix_syntax (int cflags)
+{
+  reg_syntax_t syntax = ((cflags & REG_EXTENDED) ? RE_SYNTAX_POSIX_EXTENDED
+			 : RE_SYNTAX_POSIX_BASIC);
+
+  syntax |= (cflags & REG_ICASE) ? RE_ICASE : 0;
+  syntax |= (cflags & REG_EARLIEST) ? RE_EARLIEST_MATCH : 0;
+
+  /* If REG_NEWLINE is set, newlines are treated differently.  */
+  if (cflags & REG_NEWLINE)
+    {
+      /* REG_NEWLINE implies neither . nor [^...] match newline.  */
+      syntax &= ~RE_DOT_NEWLINE;
+      syntax |= RE_HAT_LISTS_NOT_NEWLINE;
+    }
+  return syntax;
+}
+
+int
+regcomp (regex_t *__restrict preg, const char *__restrict pattern, int cflags)
+{
+  reg_errcode_t ret;
+  reg_syntax_t syntax = posix_syntax (cflags);
+
+  preg->buffer = NULL;
+  preg->allocated = 0;
+  preg->used = 0;
+
+  /* Try to allocate space for the fastmap.  */
+  preg->fastmap = re_malloc (char, SBC_MAX);
+  if (__glibc_unlikely (preg->fastmap == NULL))
+    return REG_ESPACE;
+
+  /* REG_NEWLINE also changes the matching behavior.  */
+  preg->newline_anchor = !!(cflags & REG_NEWLINE);
+  preg->no_sub = !!(cflags & REG_NOSUB);
+  preg->translate = NULL;
+
+  ret = re_compile_internal (preg, pattern, strlen (pattern), syntax);
+
+  /* POSIX doesn't distinguish between an unmatched open-group and an
+     unmatched close-group: both are REG_EPAREN.  */
+  if (ret == REG_ERPAREN)
+    ret = REG_EPAREN;
+
+  /* We have already checked preg->fastmap != NULL.  */
+  if (__glibc_likely (ret == REG_NOERROR))
+    /* Compute the fastmap now, since regexec cannot modify the pattern
+       buffer.  This function never fails in this implementation.  */
+    (void) re_compile_fastmap (preg);
+  else
+    {
+      /* Some error occurred while compiling the expression.  */
+      re_free (preg->fastmap);
+      preg->fastmap = NULL;
+    }
+
+  return (int) ret;
+}
+
+/* Returns a message corresponding to an error code, ERRCODE, returned
+   from either regcomp or regexec.   We don't use PREG here.  */
+
+size_t
+regerror (int errcode, const regex_t *__restrict preg, char *__restrict errbuf,
+	  size_t errbuf_size)
+{
+  const char *msg;
+  size_t msg_size;
+  int nerrcodes = sizeof __re_error_msgid_idx / sizeof __re_error_msgid_idx[0];
+
+  if (__glibc_unlikely (errcode < 0 || errcode >= nerrcodes))
+    /* Only error codes returned by the rest of the code should be passed
+       to this routine.  If we are given anything else, or if other regex
+       code generates an invalid error code, then the program has a bug.
+       Dump core so we can fix it.  */
+    abort ();
+
+  msg = gettext (__re_error_msgid + __re_error_msgid_idx[errcode]);
+
+  msg_size = strlen (msg) + 1; /* Includes the null.  */
+
+  if (__glibc_likely (errbuf_size != 0))
+    {
+      size_t cpy_size = msg_size;
+      if (__glibc_unlikely (msg_size > errbuf_size))
+	{
+	  cpy_size = errbuf_size - 1;
+	  errbuf[cpy_size] = '\0';
+	}
+      memcpy (errbuf, msg, cpy_size);
+    }
+
+  return msg_size;
+}
+
+/* Free dynamically allocated space used by PREG.  */
+
+void
+regfree (regex_t *preg)
+{
+  re_dfa_t *dfa = preg->buffer;
+  if (__glibc_likely (dfa != NULL))
+    {
+      lock_fini (dfa->lock);
+      free_dfa_content (dfa);
+    }
+  preg->buffer = NULL;
+  preg->allocated = 0;
+
+  re_free (preg->fastmap);
+  preg->fastmap = NULL;
+
+  re_free (preg->translate);
+  preg->translate = NULL;
+}
+
+/* Entry points for sets of patterns.  */
+
+/* regsetcomp compiles the NPATTERNS patterns in PATTERNS, with CFLAGS
+   as for regcomp, into SET: the alternation of them all, each marked
+   with its index, in one program.  On failure 're_npatterns' is set to
+   the index of the pattern at fault.  */
+
+int
+regsetcomp (regset_t *__restrict set, size_t npatterns,
+	    const char *const patterns[_REGEX_NELTS (npatterns)], int cflags)
+{
+  regex_t preg;
+  reg_errcode_t ret;
+  size_t failed = 0;
+
+  memset (&preg, 0, sizeof preg);
+  preg.newline_anchor = !!(cflags & REG_NEWLINE);
+  preg.no_sub = 1;
+  ret = re_compile_set (&preg, patterns, npatterns, posix_syntax (cflags),
+			cflags, &failed);
+  if (ret == REG_ERPAREN)
+    ret = REG_EPAREN;
+  set->buffer = preg.buffer;
+  set->re_npatterns = ret == REG_NOERROR ? npatterns : failed;
+  return (int) ret;
+}
+
+void
+regsetfree (regset_t *set)
+{
+  re_dfa_t *dfa = set->buffer;
+  if (__glibc_likely (dfa != NULL))
+    {
+      lock_fini (dfa->lock);
+      free_dfa_content (dfa);
+    }
+  set->buffer = NULL;
+  set->re_npatterns = 0;
+}
+
+/* Internal entry point.
+   Compile the regular expression PATTERN, whose length is LENGTH.
+   SYNTAX indicate regular expression's syntax.  */
+
+static reg_errcode_t
+re_compile_internal (regex_t *preg, const char * pattern, size_t length,
+		     reg_syntax_t syntax)
+{
+  reg_errcode_t err;
+  re_dfa_t *dfa;
+  re_string_t regexp;
+  struct obstack trees;
+  bin_tree_t *tree;
+
+  if (__glibc_unlikely (length > IDX_MAX))
+    return REG_ESIZE;
+  err = re_prepare_buffer (preg, syntax);
+  if (__glibc_unlikely (err != REG_NOERROR))
+    return err;
+  dfa = preg->buffer;
+
+  regexp.raw_mbs = (const unsigned char *) pattern;
+  regexp.len = length;
+  regexp.cur_idx = 0;
+  regexp.trans = dfa->has_trans ? dfa->trans : NULL;
+
+  obstack_begin (&trees, 0);
+  dfa->trees = &trees;
+
+  /* Parse the regular expression, and build a structure tree.  */
+  tree = parse (&regexp, preg, syntax, &err);
+  if (__glibc_likely (err == REG_NOERROR))
+    err = compile_progs (dfa, tree);
+
+  obstack_free (&trees, NULL);
+  dfa->trees = NULL;
+
+  if (__glibc_unlikely (err != REG_NOERROR))
+    {
+      lock_fini (dfa->lock);
+      free_dfa_content (dfa);
+      preg->buffer = NULL;
+      preg->allocated = 0;
+    }
+  return err;
+}
+
+/* Compile the NPATTERNS null-terminated PATTERNS with SYNTAX into PREG
+   as a set.  The automaton lets a backreference match anything, so the
+   patterns with backreferences are also compiled alone with CFLAGS,
+   for checking what it finds.  On failure, set *FAILED to the index of
+   the pattern at fault.  */
+
+static reg_errcode_t
+re_compile_set (regex_t *preg, const char *const *patterns, size_t npatterns,
+		reg_syntax_t syntax, int cflags, size_t *failed)
+{
+  reg_errcode_t err;
+  re_dfa_t *dfa;
+  struct obstack trees;
+  bin_tree_t **set_trees;
+  size_t i;
+
+  if (__glibc_unlikely (npatterns > IDX_MAX / sizeof (re_inst_t)))
+    return REG_ESIZE;
+  err = re_prepare_buffer (preg, syntax);
+  if (__glibc_unlikely (err != REG_NOERROR))
+    return err;
+  dfa = preg->buffer;
+
+  dfa->set_verify = calloc (npatterns + 1, sizeof (regex_t *));
+  set_trees = re_malloc (bin_tree_t *, npatterns + 1);
+  if (__glibc_unlikely (dfa->set_verify == NULL || set_trees == NULL))
+    err = REG_ESPACE;
+  dfa->set_npatterns = npatterns;
+
+  obstack_begin (&trees, 0);
+  dfa->trees = &trees;
+  for (i = 0; i < npatterns && err == REG_NOERROR; i++)
+    {
+      re_string_t regexp;
+      size_t length = strlen (patterns[i]);
+      Idx nbackref = dfa->nbackref;
+
+      *failed = i;
+      if (__glibc_unlikely (length > IDX_MAX))
+	{
+	  err = REG_ESIZE;
+	  break;
+	}
+      regexp.raw_mbs = (const unsigned char *) patterns[i];
+      regexp.len = length;
+      regexp.cur_idx = 0;
+      regexp.trans = dfa->has_trans ? dfa->trans : NULL;
+      preg->re_nsub = 0;
+      dfa->completed_bkref_map = 0;
+      set_trees[i] = parse (&regexp, preg, syntax, &err);
+
+      if (err == REG_NOERROR && dfa->nbackref != nbackref)
+	{
+	  regex_t *verify = re_malloc (regex_t, 1);
+	  if (__glibc_unlikely (verify == NULL))
+	    err = REG_ESPACE;
+	  else if ((err = regcomp (verify, patterns[i], cflags | REG_NOSUB))
+		   != REG_NOERROR)
+	    re_free (verify);
+	  else
+	    dfa->set_verify[i] = verify;
+	}
+    }
+  if (__glibc_likely (err == REG_NOERROR))
+    err = compile_set_prog (dfa, set_trees, npatterns);
+
+  obstack_free (&trees, NULL);
+  dfa->trees = NULL;
+  re_free (set_trees);
+
+  preg->re_nsub = 0;
+  if (__glibc_unlikely (err != REG_NOERROR))
+    {
+      lock_fini (dfa->lock);
+      free_dfa_content (dfa);
+      preg->buffer = NULL;
+      preg->allocated = 0;
+    }
+  return err;
+}
+
+/* Set up PREG for compiling with SYNTAX, with a fresh DFA.  */
+
+static reg_errcode_t
+re_prepare_buffer (regex_t *preg, reg_syntax_t syntax)
+{
+  reg_errcode_t err;
+  re_dfa_t *dfa;
+
+  /* Initialize the pattern buffer.  */
+  preg->fastmap_accurate = 0;
+  preg->syntax = syntax;
+  preg->not_bol = preg->not_eol = 0;
+  preg->used = 0;
+  preg->re_nsub = 0;
+  preg->can_be_null = 0;
+  preg->regs_allocated = REGS_UNALLOCATED;
+
+  /* Initialize the dfa.  */
+  dfa = preg->buffer;
+  if (__glibc_unlikely (preg->allocated < sizeof (re_dfa_t)))
+    {
+      /* If zero allocated, but buffer is non-null, try to realloc
+	 enough space.  This loses if buffer's address is bogus, but
+	 that is the user's responsibility.  If ->buffer is NULL this
+	 is a simple allocation.  */
+      dfa = re_realloc (preg->buffer, re_dfa_t, 1);
+      if (dfa == NULL)
+	return REG_ESPACE;
+      preg->allocated = sizeof (re_dfa_t);
+      preg->buffer = dfa;
+    }
+  preg->used = sizeof (re_dfa_t);
+
+  err = init_dfa (dfa, preg, syntax);
+  if (__glibc_unlikely (err == REG_NOERROR && lock_init (dfa->lock) != 0))
+    err = REG_ESPACE;
+  if (__glibc_unlikely (err != REG_NOERROR))
+    {
+      free_dfa_content (dfa);
+      preg->buffer = NULL;
+      preg->allocated = 0;
+    }
+  return err;
+}
+
+/* Initialize DFA.  We use the length of the regular expression PAT_LEN
+   as the initial length of some arrays.  */
+
+static reg_errcode_t
+init_dfa (re_dfa_t *dfa, const regex_t *preg, reg_syntax_t syntax)
+{
+  int i;
+
+  memset (dfa, '\0', sizeof (re_dfa_t));
+  dfa->cache_max = RE_DFA_CACHE_MAX;
+  dfa->newline_anchor = preg->newline_anchor;
+  dfa->earliest = !!(syntax & RE_EARLIEST_MATCH);
+
+  for (i = 0; i < SBC_MAX; ++i)
+    {
+      int ch = preg->translate ? preg->translate[i] : i;
+      dfa->trans[i] = (syntax & RE_ICASE) ? toupper (ch) : ch;
+      if (dfa->trans[i] != i)
+	dfa->has_trans = true;
+    }
+  return REG_NOERROR;
+}
+
+static void
+free_dfa_content (re_dfa_t *dfa)
+{
+  Idx i;
+
+  re_prog_free (&dfa->fwd);
+  re_prog_free (&dfa->rev);
+  re_free (dfa->sbcsets);
+  if (dfa->literals != NULL)
+    {
+      re_free (dfa->literals->trans);
+      re_free (dfa->literals);
+    }
+  if (dfa->set_verify != NULL)
+    for (i = 0; i < dfa->set_npatterns; i++)
+      if (dfa->set_verify[i] != NULL)
+	{
+	  regfree (dfa->set_verify[i]);
+	  re_free (dfa->set_verify[i]);
+	}
+  re_free (dfa->set_verify);
+  re_free (dfa);
+}
+
+/* Functions for parser.  */
+
+/* Allocate a new set of bytes in DFA, empty, and return its index.
+   Return -1 if there is no memory.  */
+
+static Idx
+new_sbcset (re_dfa_t *dfa)
+{
+  if (dfa->nsbcsets == dfa->sbcsets_alloc)
+    {
+      Idx new_alloc = dfa->sbcsets_alloc * 2 + 8;
+      bitset_t *new_sets = re_realloc (dfa->sbcsets, bitset_t, new_alloc);
+      if (__glibc_unlikely (new_sets == NULL))
+	return -1;
+      dfa->sbcsets = new_sets;
+      dfa->sbcsets_alloc = new_alloc;
+    }
+  bitset_empty (dfa->sbcsets[dfa->nsbcsets]);
+  return dfa->nsbcsets++;
+}
+
+static void
+fetch_token (re_token_t *result, re_string_t *input, reg_syntax_t syntax)
+{
+  re_string_skip_bytes (input, peek_token (result, input, syntax));
+}
+
+/* Peek a token from INPUT, and return the length of the token.
+   We must not use this function inside bracket expressions.  */
+
+static int
+peek_token (re_token_t *token, re_string_t *input, reg_syntax_t syntax)
+{
+  unsigned char c;
+
+  if (re_string_eoi (input))
+    {
+      token->type = END_OF_RE;
+      return 0;
+    }
+
+  c = re_string_peek_byte (input, 0);
+  token->opr.c = c;
+
+  if (c == '\\')
+    {
+      unsigned char c2;
+      if (re_string_cur_idx (input) + 1 >= re_string_length (input))
+	{
+	  token->type = BACK_SLASH;
+	  return 1;
+	}
+
+      c2 = re_string_peek_byte_case (input, 1);
+      token->opr.c = input->trans ? input->trans[c2] : c2;
+      token->type = CHARACTER;
+      switch (c2)
+	{
+	case '|':
+	  if (!(syntax & RE_LIMITED_OPS) && !(syntax & RE_NO_BK_VBAR))
+	    token->type = OP_ALT;
+	  break;
+	case '1': case '2': case '3': case '4': case '5':
+	case '6': case '7': case '8': case '9':
+	  if (!(syntax & RE_NO_BK_REFS))
+	    {
+	      token->type = OP_BACK_REF;
+	      token->opr.idx = c2 - '1';
+	    }
+	  break;
+	case '<':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    {
+	      token->type = ANCHOR;
+	      token->opr.ctx_type = WORD_FIRST;
+	    }
+	  break;
+	case '>':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    {
+	      token->type = ANCHOR;
+	      token->opr.ctx_type = WORD_LAST;
+	    }
+	  break;
+	case 'b':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    {
+	      token->type = ANCHOR;
+	      token->opr.ctx_type = WORD_DELIM;
+	    }
+	  break;
+	case 'B':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    {
+	      token->type = ANCHOR;
+	      token->opr.ctx_type = NOT_WORD_DELIM;
+	    }
+	  break;
+	case 'w':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    token->type = OP_WORD;
+	  break;
+	case 'W':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    token->type = OP_NOTWORD;
+	  break;
+	case 's':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    token->type = OP_SPACE;
+	  break;
+	case 'S':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    token->type = OP_NOTSPACE;
+	  break;
+	case '`':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    {
+	      token->type = ANCHOR;
+	      token->opr.ctx_type = BUF_FIRST;
+	    }
+	  break;
+	case '\'':
+	  if (!(syntax & RE_NO_GNU_OPS))
+	    {
+	      token->type = ANCHOR;
+	      token->opr.ctx_type = BUF_LAST;
+	    }
+	  break;
+	case '(':
+	  if (!(syntax & RE_NO_BK_PARENS))
+	    token->type = OP_OPEN_SUBEXP;
+	  break;
+	case ')':
+	  if (!(syntax & RE_NO_BK_PARENS))
+	    token->type = OP_CLOSE_SUBEXP;
+	  break;
+	case '+':
+	  if (!(syntax & RE_LIMITED_OPS) && (syntax & RE_BK_PLUS_QM))
+	    token->type = OP_DUP_PLUS;
+	  break;
+	case '?':
+	  if (!(syntax & RE_LIMITED_OPS) && (syntax & RE_BK_PLUS_QM))
+	    token->type = OP_DUP_QUESTION;
+	  break;
+	case '{':
+	  if ((syntax & RE_INTERVALS) && (!(syntax & RE_NO_BK_BRACES)))
+	    token->type = OP_OPEN_DUP_NUM;
+	  break;
+	case '}':
+	  if ((syntax & RE_INTERVALS) && (!(syntax & RE_NO_BK_BRACES)))
+	    token->type = OP_CLOSE_DUP_NUM;
+	  break;
+	default:
+	  break;
+	}
+      return 2;
+    }
+
+  token->type = CHARACTER;
+  switch (c)
+    {
+    case '\n':
+      if (syntax & RE_NEWLINE_ALT)
+	token->type = OP_ALT;
+      break;
+    case '|':
+      if (!(syntax & RE_LIMITED_OPS) && (syntax & RE_NO_BK_VBAR))
+	token->type = OP_ALT;
+      break;
+    case '*':
+      token->type = OP_DUP_ASTERISK;
+      break;
+    case '+':
+      if (!(syntax & RE_LIMITED_OPS) && !(syntax & RE_BK_PLUS_QM))
+	token->type = OP_DUP_PLUS;
+      break;
+    case '?':
+      if (!(syntax & RE_LIMITED_OPS) && !(syntax & RE_BK_PLUS_QM))
+	token->type = OP_DUP_QUESTION;
+      break;
+    case '{':
+      if ((syntax & RE_INTERVALS) && (syntax & RE_NO_BK_BRACES))
+	token->type = OP_OPEN_DUP_NUM;
+      break;
+    case '}':
+      if ((syntax & RE_INTERVALS) && (syntax & RE_NO_BK_BRACES))
+	token->type = OP_CLOSE_DUP_NUM;
+      break;
+    case '(':
+      if (syntax & RE_NO_BK_PARENS)
+	token->type = OP_OPEN_SUBEXP;
+      break;
+    case ')':
+      if (syntax & RE_NO_BK_PARENS)
+	token->type = OP_CLOSE_SUBEXP;
+      break;
+    case '[':
+      token->type = OP_OPEN_BRACKET;
+      break;
+    case '.':
+      token->type = OP_PERIOD;
+      break;
+    case '^':
+      if (!(syntax & (RE_CONTEXT_INDEP_ANCHORS | RE_CARET_ANCHORS_HERE))
+	  && re_string_cur_idx (input) != 0)
+	{
+	  char prev = re_string_peek_byte (input, -1);
+	  if (!(syntax & RE_NEWLINE_ALT) || prev != '\n')
+	    break;
+	}
+      token->type = ANCHOR;
+      token->opr.ctx_type = LINE_FIRST;
+      break;
+    case '$':
+      if (!(syntax & RE_CONTEXT_INDEP_ANCHORS)
+	  && re_string_cur_idx (input) + 1 != re_string_length (input))
+	{
+	  re_token_t next;
+	  re_string_skip_bytes (input, 1);
+	  peek_token (&next, input, syntax);
+	  re_string_skip_bytes (input, -1);
+	  if (next.type != OP_ALT && next.type != OP_CLOSE_SUBEXP)
+	    break;
+	}
+      token->type = ANCHOR;
+      token->opr.ctx_type = LINE_LAST;
+      break;
+    default:
+      break;
+    }
+  return 1;
+}
+
+/* Peek a token from INPUT, and return the length of the token.
+   We must not use this function out of bracket expressions.  */
+
+static int
+peek_token_bracket (re_token_t *token, re_string_t *input, reg_syntax_t syntax)
+{
+  unsigned char c;
+  if (re_string_eoi (input))
+    {
+      token->type = END_OF_RE;
+      return 0;
+    }
+  c = re_string_peek_byte (input, 0);
+  token->opr.c = c;
+
+  if (c == '\\' && (syntax & RE_BACKSLASH_ESCAPE_IN_LISTS)
+      && re_string_cur_idx (input) + 1 < re_string_length (input))
+    {
+      /* In this case, '\' escape a character.  */
+      unsigned char c2;
+      re_string_skip_bytes (input, 1);
+      c2 = re_string_peek_byte (input, 0);
+      token->opr.c = c2;
+      token->type = CHARACTER;
+      return 1;
+    }
+  if (c == '[') /* '[' is a special char in a bracket exps.  */
+    {
+      unsigned char c2;
+      int token_len;
+      if (re_string_cur_idx (input) + 1 < re_string_length (input))
+	c2 = re_string_peek_byte (input, 1);
+      else
+	c2 = 0;
+      token->opr.c = c2;
+      token_len = 2;
+      switch (c2)
+	{
+	case '.':
+	  token->type = OP_OPEN_COLL_ELEM;
+	  break;
+
+	case '=':
+	  token->type = OP_OPEN_EQUIV_CLASS;
+	  break;
+
+	case ':':
+	  if (syntax & RE_CHAR_CLASSES)
+	    {
+	      token->type = OP_OPEN_CHAR_CLASS;
+	      break;
+	    }
+	  FALLTHROUGH;
+	default:
+	  token->type = CHARACTER;
+	  token->opr.c = c;
+	  token_len = 1;
+	  break;
+	}
+      return token_len;
+    }
+  switch (c)
+    {
+    case '-':
+      token->type = OP_CHARSET_RANGE;
+      break;
+    case ']':
+      token->type = OP_CLOSE_BRACKET;
+      break;
+    case '^':
+      token->type = OP_NON_MATCH_LIST;
+      break;
+    default:
+      token->type = CHARACTER;
+    }
+  return 1;
+}
+
+/* Functions for parser.  */
+
+/* Entry point of the parser.
+   Parse the regular expression REGEXP and return the structure tree.
+   If an error occurs, ERR is set by error code, and return NULL.
+   This function build the following tree, from regular expression <reg_exp>:
+	   CAT
+	   / \
+	  /   \
+   <reg_exp>  EOR
+
+   CAT means concatenation.
+   EOR means end of regular expression.  */
+
+static bin_tree_t *
+parse (re_string_t *regexp, regex_t *preg, reg_syntax_t syntax,
+       reg_errcode_t *err)
+{
+  re_token_t current_token;
+  bin_tree_t *tree;
+
+  fetch_token (&current_token, regexp, syntax | RE_CARET_ANCHORS_HERE);
+  tree = parse_reg_exp (regexp, preg, &current_token, syntax, 0, err);
+  if (__glibc_unlikely (*err != REG_NOERROR))
+    return NULL;
+  return tree;
+}
+
+/* This function build the following tree, from regular expression
+   <branch1>|<branch2>:
+	   ALT
+	   / \
+	  /   \
+   <branch1> <branch2>
+
+   ALT means alternative, which represents the operator '|'.  */
+
+static bin_tree_t *
+parse_reg_exp (re_string_t *regexp, regex_t *preg, re_token_t *token,
+	       reg_syntax_t syntax, Idx nest, reg_errcode_t *err)
+{
+  re_dfa_t *dfa = preg->buffer;
+  bin_tree_t *tree, *branch = NULL;
+  unsigned int initial_bkref_map = dfa->completed_bkref_map;
+  tree = parse_branch (regexp, preg, token, syntax, nest, err);
+  if (__glibc_unlikely (*err != REG_NOERROR && tree == NULL))
+    return NULL;
+
+  while (token->type == OP_ALT)
+    {
+      fetch_token (token, regexp, syntax | RE_CARET_ANCHORS_HERE);
+      if (token->type != OP_ALT && token->type != END_OF_RE
+	  && (nest == 0 || token->type != OP_CLOSE_SUBEXP))
+	{
+	  unsigned int accumulated_bkref_map = dfa->completed_bkref_map;
+	  dfa->completed_bkref_map = initial_bkref_map;
+	  branch = parse_branch (regexp, preg, token, syntax, nest, err);
+	  if (__glibc_unlikely (*err != REG_NOERROR && branch == NULL))
+	    return NULL;
+	  dfa->completed_bkref_map |= accumulated_bkref_map;
+	}
+      else
+	branch = NULL;
+      tree = create_tree (dfa, tree, branch, OP_ALT);
+      if (__glibc_unlikely (tree == NULL))
+	{
+	  *err = REG_ESPACE;
+	  return NULL;
+	}
+    }
+  return tree;
+}
+
+/* This function build the following tree, from regular expression
+   <exp1><exp2>:
+	CAT
+	/ \
+       /   \
+   <exp1> <exp2>
+
+   CAT means concatenation.  */
+
+static bin_tree_t *
+parse_branch (re_string_t *regexp, regex_t *preg, re_token_t *token,
+	      reg_syntax_t syntax, Idx nest, reg_errcode_t *err)
+{
+  bin_tree_t *tree, *expr;
+  re_dfa_t *dfa = preg->buffer;
+  tree = parse_expression (regexp, preg, token, syntax, nest, err);
+  if (__glibc_unlikely (*err != REG_NOERROR && tree == NULL))
+    return NULL;
+
+  while (token->type != OP_ALT && token->type != END_OF_RE
+	 && (nest == 0 || token->type != OP_CLOSE_SUBEXP))
+    {
+      expr = parse_expression (regexp, preg, token, syntax, nest, err);
+      if (__glibc_unlikely (*err != REG_NOERROR && expr == NULL))
+	return NULL;
+      if (tree != NULL && expr != NULL)
+	{
+	  bin_tree_t *newtree = create_tree (dfa, tree, expr, CONCAT);
+	  if (newtree == NULL)
+	    {
+	      *err = REG_ESPACE;
+	      return NULL;
+	    }
+	  tree = newtree;
+	}
+      else if (tree == NULL)
+	tree = expr;
+      /* Otherwise expr == NULL, we don't need to create new tree.  */
+    }
+  return tree;
+}
+
+/* This function build the following tree, from regular expression a*:
+	 *
+	 |
+	 a
+*/
+
+static bin_tree_t *
+parse_expression (re_string_t *regexp, regex_t *preg, re_token_t *token,
+		  reg_syntax_t syntax, Idx nest, reg_errcode_t *err)
+{
+  re_dfa_t *dfa = preg->buffer;
+  bin_tree_t *tree;
+  switch (token->type)
+    {
+    case CHARACTER:
+      tree = create_token_tree (dfa, NULL, NULL, token);
+      if (__glibc_unlikely (tree == NULL))
+	{
+	  *err = REG_ESPACE;
+	  return NULL;
+	}
+      break;
+
+    case OP_OPEN_SUBEXP:
+      tree = parse_sub_exp (regexp, preg, token, syntax, nest + 1, err);
+      if (__glibc_unlikely (*err != REG_NOERROR && tree == NULL))
+	return NULL;
+      break;
+
+    case OP_OPEN_BRACKET:
+      tree = parse_bracket_exp (regexp, dfa, token, syntax, err);
+      if (__glibc_unlikely (*err != REG_NOERROR && tree == NULL))
+	return NULL;
+      break;
+
+    case OP_BACK_REF:
+      if (!__glibc_likely (dfa->completed_bkref_map & (1 << token->opr.idx)))
+	{
+	  *err = REG_ESUBREG;
+	  return NULL;
+	}
+      tree = create_token_tree (dfa, NULL, NULL, token);
+      if (__glibc_unlikely (tree == NULL))
+	{
+	  *err = REG_ESPACE;
+	  return NULL;
+	}
+      ++dfa->nbackref;
+      break;
+
+    case OP_OPEN_DUP_NUM:
+      if (syntax & RE_CONTEXT_INVALID_DUP)
+	{
+	  *err = REG_BADRPT;
+	  return NULL;
+	}
+      FALLTHROUGH;
+    case OP_DUP_ASTERISK:
+    case OP_DUP_PLUS:
+    case OP_DUP_QUESTION:
+      if ((syntax & RE_CONTEXT_INVALID_OPS)
+	  && !(syntax & RE_CONTEXT_INVALID_DUP))
+	{
+	  *err = REG_BADRPT;
+	  return NULL;
+	}
+      else if (syntax & RE_CONTEXT_INDEP_OPS)
+	{
+	  fetch_token (token, regexp, syntax);
+	  return parse_expression (regexp, preg, token, syntax, nest, err);
+	}
+      FALLTHROUGH;
+    case OP_CLOSE_SUBEXP:
+      if ((token->type == OP_CLOSE_SUBEXP)
+	  && !__glibc_unlikely (syntax & RE_UNMATCHED_RIGHT_PAREN_ORD))
+	{
+	  *err = REG_ERPAREN;
+	  return NULL;
+	}
+      FALLTHROUGH;
+    case OP_CLOSE_DUP_NUM:
+      /* We treat it as a normal character.  */
+
+      /* Then we can these characters as normal characters.  */
+      token->type = CHARACTER;
+      tree = create_token_tree (dfa, NULL, NULL, token);
+      if (__glibc_unlikely (tree == NULL))
+	{
+	  *err = REG_ESPACE;
+	  return NULL;
+	}
+      break;
+
+    case ANCHOR:
+      tree = create_token_tree (dfa, NULL, NULL, token);
+      if (__glibc_unlikely (tree == NULL))
+	{
+	  *err = REG_ESPACE;
+	  return NULL;
+	}
+      /* We must return here, since ANCHORs can't be followed
+	 by repetition operators.
+	 eg. RE "^*" is invalid or "<ANCHOR(^)><CHAR(*)>",
+	     it must not be "<ANCHOR(^)><REPEAT(*)>".  */
+      fetch_token (token, regexp, syntax);
+      return tree;
+
+    case OP_PERIOD:
+      {
+	re_token_t bracket;
+	Idx idx = new_sbcset (dfa);
+	if (__glibc_unlikely (idx < 0))
+	  {
+	    *err = REG_ESPACE;
+	    return NULL;
+	  }
+	bitset_set_all (dfa->sbcsets[idx]);
+	if (!(syntax & RE_DOT_NEWLINE))
+	  bitset_clear (dfa->sbcsets[idx], '\n');
+	if (syntax & RE_DOT_NOT_NULL)
+	  bitset_clear (dfa->sbcsets[idx], '\0');
+	bracket.type = SIMPLE_BRACKET;
+	bracket.opr.idx = idx;
+	tree = create_token_tree (dfa, NULL, NULL, &bracket);
+	if (__glibc_unlikely (tree == NULL))
+	  {
+	    *err = REG_ESPACE;
+	    return NULL;
+	  }
+      }
+      break;
+
+    case OP_WORD:
+    case OP_NOTWORD:
+      tree = build_charclass_op (dfa, regexp->trans,
+				 "alnum",
+				 "_",
+				 token->type == OP_NOTWORD, err);
+      if (__glibc_unlikely (*err != REG_NOERROR && tree == NULL))
+	return NULL;
+      break;
+
+    case OP_SPACE:
+    case OP_NOTSPACE:
+      tree = build_charclass_op (dfa, regexp->trans,
+				 "space",
+				 "",
+				 token->type == OP_NOTSPACE, err);
+      if (__glibc_unlikely (*err != REG_NOERROR && tree == NULL))
+	return NULL;
+      break;
+
+    case OP_ALT:
+    case END_OF_RE:
+      return NULL;
+
+    case BACK_SLASH:
+      *err = REG_EESCAPE;
+      return NULL;
+
+    default:
+      /* Must not happen?  */
+      *err = REG_BADPAT;
+      return NULL;
+    }
+  fetch_token (token, regexp, syntax);
+
+  while (token->type == OP_DUP_ASTERISK || token->type == OP_DUP_PLUS
+	 || token->type == OP_DUP_QUESTION || token->type == OP_OPEN_DUP_NUM)
+    {
+      bin_tree_t *dup_tree = parse_dup_op (tree, regexp, dfa, token,
+					   syntax, err);
+      if (__glibc_unlikely (*err != REG_NOERROR && dup_tree == NULL))
+	return NULL;
+      tree = dup_tree;
+      /* In BRE consecutive duplications are not allowed.  */
+      if ((syntax & RE_CONTEXT_INVALID_DUP)
+	  && (token->type == OP_DUP_ASTERISK
+	      || token->type == OP_OPEN_DUP_NUM))
+	{
+	  *err = REG_BADRPT;
+	  return NULL;
+	}
+    }
+
+  return tree;
+}
+
+/* This function build the following tree, from regular expression
+   (<reg_exp>):
+	 SUBEXP
+	    |
+	<reg_exp>
+*/
+
+static bin_tree_t *
+parse_sub_exp (re_string_t *regexp, regex_t *preg, re_token_t *token,
+	       reg_syntax_t syntax, Idx nest, reg_errcode_t *err)
+{
+  re_dfa_t *dfa = preg->buffer;
+  bin_tree_t *tree;
+  size_t cur_nsub;
+  cur_nsub = preg->re_nsub++;
+
+  fetch_token (token, regexp, syntax | RE_CARET_ANCHORS_HERE);
+
+  /* The subexpression may be a null string.  */
+  if (token->type == OP_CLOSE_SUBEXP)
+    tree = NULL;
+  else
+    {
+      tree = parse_reg_exp (regexp, preg, token, syntax, nest, err);
+      if (__glibc_unlikely (*err == REG_NOERROR
+			    && token->type != OP_CLOSE_SUBEXP))
+	*err = REG_EPAREN;
+      if (__glibc_unlikely (*err != REG_NOERROR))
+	return NULL;
+    }
+
+  if (cur_nsub <= '9' - '1')
+    dfa->completed_bkref_map |= 1 << cur_nsub;
+
+  tree = create_tree (dfa, tree, NULL, SUBEXP);
+  if (__glibc_unlikely (tree == NULL))
+    {
+      *err = REG_ESPACE;
+      return NULL;
+    }
+  tree->token.opr.idx = cur_nsub;
+  return tree;
+}
+
+/* This function parse repetition operators like "*", "+", "{1,3}" etc.  */
+
+static bin_tree_t *
+parse_dup_op (bin_tree_t *elem, re_string_t *regexp, re_dfa_t *dfa,
+	      re_token_t *token, reg_syntax_t syntax, reg_errcode_t *err)
+{
+  bin_tree_t *tree;
+  Idx start, end, start_idx = re_string_cur_idx (regexp);
+  re_token_t start_token = *token;
+
+  if (token->type == OP_OPEN_DUP_NUM)
+    {
+      end = 0;
+      start = fetch_number (regexp, token, syntax);
+      if (start == -1)
+	{
+	  if (token->type == CHARACTER && token->opr.c == ',')
+	    start = 0; /* We treat "{,m}" as "{0,m}".  */
+	  else
+	    {
+	      *err = REG_BADBR; /* <re>{} is invalid.  */
+	      return NULL;
+	    }
+	}
+      if (__glibc_likely (start != -2))
+	{
+	  /* We treat "{n}" as "{n,n}".  */
+	  end = ((token->type == OP_CLOSE_DUP_NUM) ? start
+		 : ((token->type == CHARACTER && token->opr.c == ',')
+		    ? fetch_number (regexp, token, syntax) : -2));
+	}
+      if (__glibc_unlikely (start == -2 || end == -2))
+	{
+	  /* Invalid sequence.  */
+	  if (__glibc_unlikely (!(syntax & RE_INVALID_INTERVAL_ORD)))
+	    {
+	      if (token->type == END_OF_RE)
+		*err = REG_EBRACE;
+	      else
+		*err = REG_BADBR;
+
+	      return NULL;
+	    }
+
+	  /* If the syntax bit is set, rollback.  */
+	  re_string_set_index (regexp, start_idx);
+	  *token = start_token;
+	  token->type = CHARACTER;
+	  return elem;
+	}
+
+      if (__glibc_unlikely ((end != -1 && start > end)
+			    || token->type != OP_CLOSE_DUP_NUM))
+	{
+	  /* First number greater than second.  */
+	  *err = REG_BADBR;
+	  return NULL;
+	}
+
+      if (__glibc_unlikely (RE_DUP_MAX < (end == -1 ? start : end)))
+	{
+	  *err = REG_ESIZE;
+	  return NULL;
+	}
+    }
+  else
+    {
+      start = (token->type == OP_DUP_PLUS) ? 1 : 0;
+      end = (token->type == OP_DUP_QUESTION) ? 1 : -1;
+    }
+
+  fetch_token (token, regexp, syntax);
+
+  if (__glibc_unlikely (elem == NULL))
+    return NULL;
+  if (__glibc_unlikely (start == 0 && end == 0))
+    return NULL;
+  if (start == 1 && end == 1)
+    return elem;
+
+  tree = create_tree (dfa, elem, NULL, OP_DUP_ASTERISK);
+  if (__glibc_unlikely (tree == NULL))
+    {
+      *err = REG_ESPACE;
+      return NULL;
+    }
+  tree->min = start;
+  tree->max = end;
+  return tree;
+}
+
+/* Size of the names in [:class:], [.elem.] and [=equiv=].  */
+#define BRACKET_NAME_BUF_SIZE 32
+
+  /* Local function for parse_bracket_exp used in _LIBC environment.
+     Build the range expression which starts from START_ELEM, and ends
+     at END_ELEM.  The result are written to MBCSET and SBCSET.
+     RANGE_ALLOC is the allocated size of mbcset->range_starts, and
+     mbcset->range_ends, is a pointer argument since we may
+     update it.  */
+
+static reg_errcode_t
+build_range_exp (bitset_t sbcset, reg_syntax_t syntax,
+		 bracket_elem_t *start_elem, bracket_elem_t *end_elem)
+{
+  unsigned int start_ch, end_ch, ch;
+
+  /* Equivalence Classes and Character Classes can't be a range
+     start/end.  */
+  if (__glibc_unlikely (start_elem->type == EQUIV_CLASS
+			|| start_elem->type == CHAR_CLASS
+			|| end_elem->type == EQUIV_CLASS
+			|| end_elem->type == CHAR_CLASS))
+    return REG_ERANGE;
+
+  /* We can handle no multi character collating elements.  */
+  if (__glibc_unlikely ((start_elem->type == COLL_SYM
+			 && strlen ((char *) start_elem->opr.name) > 1)
+			|| (end_elem->type == COLL_SYM
+			    && strlen ((char *) end_elem->opr.name) > 1)))
+    return REG_ECOLLATE;
+
+  start_ch = ((start_elem->type == SB_CHAR) ? start_elem->opr.ch
+	      : start_elem->opr.name[0]);
+  end_ch = ((end_elem->type == SB_CHAR) ? end_elem->opr.ch
+	    : end_elem->opr.name[0]);
+  if (__glibc_unlikely ((syntax & RE_NO_EMPTY_RANGES) && start_ch > end_ch))
+    return REG_ERANGE;
+
+  for (ch = start_ch; ch <= end_ch; ++ch)
+    bitset_set (sbcset, ch);
+
+  return REG_NOERROR;
+}
+
+  /* Local function for parse_bracket_exp.
+     Build the collating element which is represented by NAME.
+     Only single byte collating elements exist in this implementation,
+     as in the C locale.  */
+
+static reg_errcode_t
+build_collating_symbol (bitset_t sbcset, const unsigned char *name)
+{
+  size_t name_len = strlen ((const char *) name);
+  if (__glibc_unlikely (name_len != 1))
+    return REG_ECOLLATE;
+  else
+    {
+      bitset_set (sbcset, name[0]);
+      return REG_NOERROR;
+    }
+}
+
+/* This function parse bracket expression like "[abc]", "[a-c]",
+   "[[.a-a.]]" etc.  */
+
+static bin_tree_t *
+parse_bracket_exp (re_string_t *regexp, re_dfa_t *dfa, re_token_t *token,
+		   reg_syntax_t syntax, reg_errcode_t *err)
+{
+  re_token_t br_token;
+  bitset_t sbcset;
+  bool non_match = false;
+  bin_tree_t *work_tree;
+  int token_len;
+  bool first_round = true;
+  Idx idx;
+
+  bitset_empty (sbcset);
+  token_len = peek_token_bracket (token, regexp, syntax);
+  if (__glibc_unlikely (token->type == END_OF_RE))
+    {
+      *err = REG_BADPAT;
+      return NULL;
+    }
+  if (token->type == OP_NON_MATCH_LIST)
+    {
+      non_match = true;
+      if (syntax & RE_HAT_LISTS_NOT_NEWLINE)
+	bitset_set (sbcset, '\n');
+      re_string_skip_bytes (regexp, token_len); /* Skip a token.  */
+      token_len = peek_token_bracket (token, regexp, syntax);
+      if (__glibc_unlikely (token->type == END_OF_RE))
+	{
+	  *err = REG_BADPAT;
+	  return NULL;
+	}
+    }
+
+  /* We treat the first ']' as a normal character.  */
+  if (token->type == OP_CLOSE_BRACKET)
+    token->type = CHARACTER;
+
+  while (1)
+    {
+      bracket_elem_t start_elem, end_elem;
+      unsigned char start_name_buf[BRACKET_NAME_BUF_SIZE];
+      unsigned char end_name_buf[BRACKET_NAME_BUF_SIZE];
+      reg_errcode_t ret;
+      int token_len2 = 0;
+      bool is_range_exp = false;
+      re_token_t token2;
+
+      start_elem.opr.name = start_name_buf;
+      start_elem.type = COLL_SYM;
+      ret = parse_bracket_element (&start_elem, regexp, token, token_len,
+				   syntax, first_round);
+      if (__glibc_unlikely (ret != REG_NOERROR))
+	{
+	  *err = ret;
+	  return NULL;
+	}
+      first_round = false;
+
+      /* Get information about the next token.  We need it in any case.  */
+      token_len = peek_token_bracket (token, regexp, syntax);
+
+      /* Do not check for ranges if we know they are not allowed.  */
+      if (start_elem.type != CHAR_CLASS && start_elem.type != EQUIV_CLASS)
+	{
+	  if (__glibc_unlikely (token->type == END_OF_RE))
+	    {
+	      *err = REG_EBRACK;
+	      return NULL;
+	    }
+	  if (token->type == OP_CHARSET_RANGE)
+	    {
+	      re_string_skip_bytes (regexp, token_len); /* Skip '-'.  */
+	      token_len2 = peek_token_bracket (&token2, regexp, syntax);
+	      if (__glibc_unlikely (token2.type == END_OF_RE))
+		{
+		  *err = REG_EBRACK;
+		  return NULL;
+		}
+	      if (token2.type == OP_CLOSE_BRACKET)
+		{
+		  /* We treat the last '-' as a normal character.  */
+		  re_string_skip_bytes (regexp, -token_len);
+		  token->type = CHARACTER;
+		}
+	      else
+		is_range_exp = true;
+	    }
+	}
+
+      if (is_range_exp == true)
+	{
+	  end_elem.opr.name = end_name_buf;
+	  end_elem.type = COLL_SYM;
+	  ret = parse_bracket_element (&end_elem, regexp, &token2, token_len2,
+				       syntax, true);
+	  if (__glibc_unlikely (ret != REG_NOERROR))
+	    {
+	      *err = ret;
+	      return NULL;
+	    }
+
+	  token_len = peek_token_bracket (token, regexp, syntax);
+
+	  *err = build_range_exp (sbcset, syntax, &start_elem, &end_elem);
+	  if (__glibc_unlikely (*err != REG_NOERROR))
+	    return NULL;
+	}
+      else
+	{
+	  switch (start_elem.type)
+	    {
+	    case SB_CHAR:
+	      bitset_set (sbcset, start_elem.opr.ch);
+	      break;
+	    case EQUIV_CLASS:
+	    case COLL_SYM:
+	      *err = build_collating_symbol (sbcset, start_elem.opr.name);
+	      if (__glibc_unlikely (*err != REG_NOERROR))
+		return NULL;
+	      break;
+	    case CHAR_CLASS:
+	      *err = build_charclass (regexp->trans, sbcset,
+				      (const char *) start_elem.opr.name,
+				      syntax);
+	      if (__glibc_unlikely (*err != REG_NOERROR))
+	       return NULL;
+	      break;
+	    }
+	}
+      if (__glibc_unlikely (token->type == END_OF_RE))
+	{
+	  *err = REG_EBRACK;
+	  return NULL;
+	}
+      if (token->type == OP_CLOSE_BRACKET)
+	break;
+    }
+
+  re_string_skip_bytes (regexp, token_len); /* Skip a token.  */
+
+  /* If it is non-matching list.  */
+  if (non_match)
+    bitset_not (sbcset);
+
+  idx = new_sbcset (dfa);
+  if (__glibc_unlikely (idx < 0))
+    {
+      *err = REG_ESPACE;
+      return NULL;
+    }
+  bitset_copy (dfa->sbcsets[idx], sbcset);
+  br_token.type = SIMPLE_BRACKET;
+  br_token.opr.idx = idx;
+  work_tree = create_token_tree (dfa, NULL, NULL, &br_token);
+  if (__glibc_unlikely (work_tree == NULL))
+    *err = REG_ESPACE;
+  return work_tree;
+}
+
+/* Parse an element in the bracket expression.  */
+
+static reg_errcode_t
+parse_bracket_element (bracket_elem_t *elem, re_string_t *regexp,
+		       re_token_t *token, int token_len,
+		       reg_syntax_t syntax, bool accept_hyphen)
+{
+  re_string_skip_bytes (regexp, token_len); /* Skip a token.  */
+  if (token->type == OP_OPEN_COLL_ELEM || token->type == OP_OPEN_CHAR_CLASS
+      || token->type == OP_OPEN_EQUIV_CLASS)
+    return parse_bracket_symbol (elem, regexp, token);
+  if (__glibc_unlikely (token->type == OP_CHARSET_RANGE) && !accept_hyphen)
+    {
+      /* A '-' must only appear as anything but a range indicator before
+	 the closing bracket.  Everything else is an error.  */
+      re_token_t token2;
+      (void) peek_token_bracket (&token2, regexp, syntax);
+      if (token2.type != OP_CLOSE_BRACKET)
+	/* The actual error value is not standardized since this whole
+	   case is undefined.  But ERANGE makes good sense.  */
+	return REG_ERANGE;
+    }
+  elem->type = SB_CHAR;
+  elem->opr.ch = token->opr.c;
+  return REG_NOERROR;
+}
+
+/* Parse a bracket symbol in the bracket expression.  Bracket symbols are
+   such as [:<character_class>:], [.<collating_element>.], and
+   [=<equivalent_class>=].  */
+
+static reg_errcode_t
+parse_bracket_symbol (bracket_elem_t *elem, re_string_t *regexp,
+		      re_token_t *token)
+{
+  unsigned char ch, delim = token->opr.c;
+  int i = 0;
+  if (re_string_eoi(regexp))
+    return REG_EBRACK;
+  for (;; ++i)
+    {
+      if (i >= BRACKET_NAME_BUF_SIZE)
+	return REG_EBRACK;
+      if (token->type == OP_OPEN_CHAR_CLASS)
+	ch = re_string_fetch_byte_case (regexp);
+      else
+	ch = re_string_fetch_byte (regexp);
+      if (re_string_eoi(regexp))
+	return REG_EBRACK;
+      if (ch == delim && re_string_peek_byte (regexp, 0) == ']')
+	break;
+      elem->opr.name[i] = ch;
+    }
+  re_string_skip_bytes (regexp, 1);
+  elem->opr.name[i] = '\0';
+  switch (token->type)
+    {
+    case OP_OPEN_COLL_ELEM:
+      elem->type = COLL_SYM;
+      break;
+    case OP_OPEN_EQUIV_CLASS:
+      elem->type = EQUIV_CLASS;
+      break;
+    case OP_OPEN_CHAR_CLASS:
+      elem->type = CHAR_CLASS;
+      break;
+    default:
+      break;
+    }
+  return REG_NOERROR;
+}
+
+  /* Helper function for parse_bracket_exp.
+     Build the character class which is represented by NAME.
+     The result are written to SBCSET.  */
+
+static reg_errcode_t
+build_charclass (const unsigned char *trans, bitset_t sbcset,
+		 const char *class_name, reg_syntax_t syntax)
+{
+  int i;
+  const char *name = class_name;
+
+  /* In case of REG_ICASE "upper" and "lower" match the both of
+     upper and lower cases.  */
+  if ((syntax & RE_ICASE)
+      && (strcmp (name, "upper") == 0 || strcmp (name, "lower") == 0))
+    name = "alpha";
+
+#define BUILD_CHARCLASS_LOOP(ctype_func)	\
+  do {						\
+    if (__glibc_unlikely (trans != NULL))	\
+      {						\
+	for (i = 0; i < SBC_MAX; ++i)		\
+	  if (ctype_func (i))			\
+	    bitset_set (sbcset, trans[i]);	\
+      }						\
+    else					\
+      {						\
+	for (i = 0; i < SBC_MAX; ++i)		\
+	  if (ctype_func (i))			\
+	    bitset_set (sbcset, i);		\
+      }						\
+  } while (0)
+
+  if (strcmp (name, "alnum") == 0)
+    BUILD_CHARCLASS_LOOP (isalnum);
+  else if (strcmp (name, "cntrl") == 0)
+    BUILD_CHARCLASS_LOOP (iscntrl);
+  else if (strcmp (name, "lower") == 0)
+    BUILD_CHARCLASS_LOOP (islower);
+  else if (strcmp (name, "space") == 0)
+    BUILD_CHARCLASS_LOOP (isspace);
+  else if (strcmp (name, "alpha") == 0)
+    BUILD_CHARCLASS_LOOP (isalpha);
+  else if (strcmp (name, "digit") == 0)
+    BUILD_CHARCLASS_LOOP (isdigit);
+  else if (strcmp (name, "print") == 0)
+    BUILD_CHARCLASS_LOOP (isprint);
+  else if (strcmp (name, "upper") == 0)
+    BUILD_CHARCLASS_LOOP (isupper);
+  else if (strcmp (name, "blank") == 0)
+    BUILD_CHARCLASS_LOOP (isblank);
+  else if (strcmp (name, "graph") == 0)
+    BUILD_CHARCLASS_LOOP (isgraph);
+  else if (strcmp (name, "punct") == 0)
+    BUILD_CHARCLASS_LOOP (ispunct);
+  else if (strcmp (name, "xdigit") == 0)
+    BUILD_CHARCLASS_LOOP (isxdigit);
+  else
+    return REG_ECTYPE;
+
+  return REG_NOERROR;
+}
+
+static bin_tree_t *
+build_charclass_op (re_dfa_t *dfa, const unsigned char *trans,
+		    const char *class_name,
+		    const char *extra, bool non_match,
+		    reg_errcode_t *err)
+{
+  re_token_t br_token;
+  bin_tree_t *tree;
+  Idx idx = new_sbcset (dfa);
+  reg_errcode_t ret;
+
+  if (__glibc_unlikely (idx < 0))
+    {
+      *err = REG_ESPACE;
+      return NULL;
+    }
+
+  /* We don't care the syntax in this case.  */
+  ret = build_charclass (trans, dfa->sbcsets[idx], class_name, 0);
+  if (__glibc_unlikely (ret != REG_NOERROR))
+    {
+      *err = ret;
+      return NULL;
+    }
+  /* \w match '_' also.  */
+  for (; *extra; extra++)
+    bitset_set (dfa->sbcsets[idx], *extra);
+
+  /* If it is non-matching list.  */
+  if (non_match)
+    bitset_not (dfa->sbcsets[idx]);
+
+  br_token.type = SIMPLE_BRACKET;
+  br_token.opr.idx = idx;
+  tree = create_token_tree (dfa, NULL, NULL, &br_token);
+  if (__glibc_unlikely (tree == NULL))
+    *err = REG_ESPACE;
+  return tree;
+}
+
+/* This is intended for the expressions like "a{1,3}".
+   Fetch a number from 'input', and return the number.
+   Return -1 if the number field is empty like "{,1}".
+   Return RE_DUP_MAX + 1 if the number field is too large.
+   Return -2 if an error occurred.  */
+
+static Idx
+fetch_number (re_string_t *input, re_token_t *token, reg_syntax_t syntax)
+{
+  Idx num = -1;
+  unsigned char c;
+  while (1)
+    {
+      fetch_token (token, input, syntax);
+      c = token->opr.c;
+      if (__glibc_unlikely (token->type == END_OF_RE))
+	return -2;
+      if (token->type == OP_CLOSE_DUP_NUM || c == ',')
+	break;
+      num = ((token->type != CHARACTER || c < '0' || '9' < c || num == -2)
+	     ? -2
+	     : num == -1
+	     ? c - '0'
+	     : num * 10 + c - '0' > RE_DUP_MAX
+	     ? RE_DUP_MAX + 1
+	     : num * 10 + c - '0');
+    }
+  return num;
+}
+
+/* Functions for binary tree operation.  */
+
+/* Create a tree node.  */
+
+static bin_tree_t *
+create_tree (re_dfa_t *dfa, bin_tree_t *left, bin_tree_t *right,
+	     re_token_type_t type)
+{
+  re_token_t t;
+  t.type = type;
+  return create_token_tree (dfa, left, right, &t);
+}
+
+static bin_tree_t *
+create_token_tree (re_dfa_t *dfa, bin_tree_t *left, bin_tree_t *right,
+		   const re_token_t *token)
+{
+  bin_tree_t *tree = obstack_try_alloc (dfa->trees, sizeof (bin_tree_t));
+  if (__glibc_unlikely (tree == NULL))
+    return NULL;
+  tree->left = left;
+  tree->right = right;
+  tree->token = *token;
+  tree->min = tree->max = 0;
+  return tree;
+}
+
+/* Functions for the compiler.  */
+
+/* Programs may not have more instructions than this.  */
+#ifndef RE_PROG_MAX
+# define RE_PROG_MAX (1 << 22)
+#endif
+
+typedef struct
+{
+  re_dfa_t *dfa;
+  re_prog_t *prog;
+  Idx alloc;
+  bool reverse;
+  /* The set of each single byte, once made.  */
+  Idx *char_sbcset;
+} re_compiler_t;
+
+static Idx
+emit (re_compiler_t *c, re_opcode_t opcode, Idx arg, Idx x, Idx y)
+{
+  re_prog_t *prog = c->prog;
+  re_inst_t *inst;
+  if (prog->ninsts == c->alloc)
+    {
+      Idx new_alloc = c->alloc * 2 + 16;
+      re_inst_t *new_insts;
+      if (__glibc_unlikely (prog->ninsts >= RE_PROG_MAX))
+	return -2;
+      new_insts = re_realloc (prog->insts, re_inst_t, new_alloc);
+      if (__glibc_unlikely (new_insts == NULL))
+	return -1;
+      prog->insts = new_insts;
+      c->alloc = new_alloc;
+    }
+  inst = &prog->insts[prog->ninsts];
+  inst->opcode = opcode;
+  inst->arg = arg;
+  inst->x = x;
+  inst->y = y;
+  return prog->ninsts++;
+}
+
+#define EMIT(c, opcode, arg, x, y, pc)				\
+  do {								\
+    (pc) = emit (c, opcode, arg, x, y);				\
+    if (__glibc_unlikely ((pc) < 0))				\
+      return (pc) == -1 ? REG_ESPACE : REG_ESIZE;		\
+  } while (0)
+
+static reg_errcode_t gen_tree (re_compiler_t *c, const bin_tree_t *node);
+
+/* Emit the chain of concatenations or alternatives rooted at NODE, whose
+   type is TYPE.  Parsing made the chain lean left, as deep as the
+   pattern is long, so it is flattened instead of recursed into.  */
+
+static reg_errcode_t
+gen_chain (re_compiler_t *c, const bin_tree_t *node, re_token_type_t type)
+{
+  const bin_tree_t *n;
+  const bin_tree_t **elems;
+  Idx nelems = 1, i, pc;
+  reg_errcode_t err = REG_NOERROR;
+
+  for (n = node; n->token.type == type; n = n->left)
+    if (++nelems, n->left == NULL)
+      break;
+  elems = re_malloc (const bin_tree_t *, nelems);
+  if (__glibc_unlikely (elems == NULL))
+    return REG_ESPACE;
+  for (i = nelems, n = node; n != NULL && n->token.type == type; n = n->left)
+    elems[--i] = n->right;
+  elems[0] = n;
+
+  if (type == CONCAT)
+    for (i = 0; i < nelems && err == REG_NOERROR; i++)
+      err = gen_tree (c, elems[c->reverse ? nelems - 1 - i : i]);
+  else
+    {
+      /* Each alternative but the last is entered through an INST_ALT
+	 preferring it, and jumps to the end when done; the jumps are
+	 linked through their X until the end is known.  */
+      Idx jumps = -1;
+      for (i = 0; i < nelems && err == REG_NOERROR; i++)
+	{
+	  Idx alt = -1;
+	  if (i + 1 < nelems)
+	    {
+	      pc = emit (c, INST_ALT, 0, c->prog->ninsts + 1, -1);
+	      if (pc < 0)
+		break;
+	      alt = pc;
+	    }
+	  err = gen_tree (c, elems[i]);
+	  if (err == REG_NOERROR && alt >= 0)
+	    {
+	      pc = emit (c, INST_JMP, 0, jumps, 0);
+	      if (pc < 0)
+		break;
+	      jumps = pc;
+	      c->prog->insts[alt].y = c->prog->ninsts;
+	    }
+	}
+      if (i < nelems && err == REG_NOERROR)
+	err = pc == -1 ? REG_ESPACE : REG_ESIZE;
+      while (err == REG_NOERROR && jumps >= 0)
+	{
+	  Idx next = c->prog->insts[jumps].x;
+	  c->prog->insts[jumps].x = c->prog->ninsts;
+	  jumps = next;
+	}
+    }
+  re_free (elems);
+  return err;
+}
+
+static reg_errcode_t
+gen_tree (re_compiler_t *c, const bin_tree_t *node)
+{
+  re_dfa_t *dfa = c->dfa;
+  reg_errcode_t err;
+  Idx pc, i;
+
+  if (node == NULL)
+    return REG_NOERROR;
+  switch (node->token.type)
+    {
+    case CHARACTER:
+      {
+	unsigned char ch = node->token.opr.c;
+	if (c->char_sbcset[ch] < 0)
+	  {
+	    Idx idx = new_sbcset (dfa);
+	    if (__glibc_unlikely (idx < 0))
+	      return REG_ESPACE;
+	    bitset_set (dfa->sbcsets[idx], ch);
+	    c->char_sbcset[ch] = idx;
+	  }
+	EMIT (c, INST_CHARSET, c->char_sbcset[ch], 0, 0, pc);
+      }
+      break;
+
+    case SIMPLE_BRACKET:
+      EMIT (c, INST_CHARSET, node->token.opr.idx, 0, 0, pc);
+      break;
+
+    case ANCHOR:
+      {
+	/* Backwards, what is before a position is after it.  */
+	static const re_context_type mirror[] =
+	  {
+	    [WORD_FIRST] = WORD_LAST, [WORD_LAST] = WORD_FIRST,
+	    [WORD_DELIM] = WORD_DELIM, [NOT_WORD_DELIM] = NOT_WORD_DELIM,
+	    [LINE_FIRST] = LINE_LAST, [LINE_LAST] = LINE_FIRST,
+	    [BUF_FIRST] = BUF_LAST, [BUF_LAST] = BUF_FIRST
+	  };
+	re_context_type type = node->token.opr.ctx_type;
+	EMIT (c, INST_ANCHOR, c->reverse ? mirror[type] : type, 0, 0, pc);
+      }
+      break;
+
+    case OP_BACK_REF:
+      EMIT (c, INST_BACKREF, node->token.opr.idx, 0, 0, pc);
+      break;
+
+    case SUBEXP:
+      {
+	Idx reg = 2 * node->token.opr.idx + 2;
+	EMIT (c, INST_SAVE, reg + c->reverse, 0, 0, pc);
+	err = gen_tree (c, node->left);
+	if (__glibc_unlikely (err != REG_NOERROR))
+	  return err;
+	EMIT (c, INST_SAVE, reg + !c->reverse, 0, 0, pc);
+      }
+      break;
+
+    case CONCAT:
+    case OP_ALT:
+      return gen_chain (c, node, node->token.type);
+
+    case OP_DUP_ASTERISK:
+      /* The copies of the subexpressions in the operand record in the
+	 same registers, so the last iteration wins.  */
+      for (i = 0; i < node->min - (node->max == -1); i++)
+	{
+	  err = gen_tree (c, node->left);
+	  if (__glibc_unlikely (err != REG_NOERROR))
+	    return err;
+	}
+      if (node->max == -1)
+	{
+	  /* a* is (a+)?, so that an operand matching the empty string
+	     is gone through once, setting its subexpressions.  */
+	  Idx skip = -1, body;
+	  if (node->min == 0)
+	    EMIT (c, INST_ALT, 0, c->prog->ninsts + 1, -1, skip);
+	  body = c->prog->ninsts;
+	  err = gen_tree (c, node->left);
+	  if (__glibc_unlikely (err != REG_NOERROR))
+	    return err;
+	  EMIT (c, INST_ALT, 0, body, c->prog->ninsts + 1, pc);
+	  if (skip >= 0)
+	    c->prog->insts[skip].y = c->prog->ninsts;
+	}
+      else
+	{
+	  /* a{2,4} is aa(a(a)?)?: each optional copy is entered through
+	     an INST_ALT whose Y, linked through until the end is
+	     known, skips to the end.  */
+	  Idx skips = -1;
+	  for (; i < node->max; i++)
+	    {
+	      EMIT (c, INST_ALT, 0, c->prog->ninsts + 1, skips, pc);
+	      skips = pc;
+	      err = gen_tree (c, node->left);
+	      if (__glibc_unlikely (err != REG_NOERROR))
+		return err;
+	    }
+	  while (skips >= 0)
+	    {
+	      Idx next = c->prog->insts[skips].y;
+	      c->prog->insts[skips].y = c->prog->ninsts;
+	      skips = next;
+	    }
+	}
+      break;
+
+    default:
+      return REG_BADPAT;
+    }
+  return REG_NOERROR;
+}
+
+/* Compile TREE into one of the programs of C->dfa.  */
+
+static reg_errcode_t
+compile_prog (re_compiler_t *c, re_prog_t *prog, const bin_tree_t *tree,
+	      bool reverse)
+{
+  reg_errcode_t err;
+  Idx pc;
+
+  c->prog = prog;
+  c->alloc = 0;
+  c->reverse = reverse;
+  /* The entry is never jumped back to, so a state holding it holds a
+     thread that has just started.  */
+  EMIT (c, INST_SAVE, reverse, 0, 0, pc);
+  err = gen_tree (c, tree);
+  if (__glibc_unlikely (err != REG_NOERROR))
+    return err;
+  EMIT (c, INST_SAVE, !reverse, 0, 0, pc);
+  EMIT (c, INST_MATCH, 0, 0, 0, pc);
+  return re_prog_init (prog);
+}
+
+/* Split the bytes into classes that no instruction of DFA tells apart,
+   so that its states need a transition per class only.  */
+
+static void
+calc_byteclasses (re_dfa_t *dfa)
+{
+  unsigned char *cls = dfa->byteclass;
+  Idx i;
+  int c, n = 1;
+
+  memset (cls, 0, SBC_MAX);
+  for (i = -2; i < dfa->nsbcsets; i++)
+    {
+      short remap[SBC_MAX][2];
+      int m = 0;
+      memset (remap, -1, sizeof remap);
+      for (c = 0; c < SBC_MAX; c++)
+	{
+	  bool in = (i == -2 ? (dfa->ctx_used & CONTEXT_WORD) && IS_WORD_CHAR (c)
+		     : i == -1 ? (dfa->ctx_used & CONTEXT_NEWLINE) && c == '\n'
+		     : bitset_contain (dfa->sbcsets[i], c));
+	  if (remap[cls[c]][in] < 0)
+	    remap[cls[c]][in] = m++;
+	  cls[c] = remap[cls[c]][in];
+	}
+      n = m;
+      /* Nothing can be split any further.  */
+      if (n == SBC_MAX)
+	break;
+    }
+  dfa->nclasses = n;
+  for (c = SBC_MAX - 1; c >= 0; c--)
+    dfa->class_byte[cls[c]] = c;
+}
+
+/* Set what DFA knows of the context each byte class makes, for
+   NEWLINE_ANCHOR.  */
+
+static void
+re_dfa_set_context (re_dfa_t *dfa, bool newline_anchor)
+{
+  int k;
+  for (k = 0; k < dfa->nclasses; k++)
+    {
+      unsigned char c = dfa->class_byte[k];
+      dfa->class_context[k] = (((IS_WORD_CHAR (c) ? CONTEXT_WORD : 0)
+				| (newline_anchor && c == NEWLINE_CHAR
+				   ? CONTEXT_NEWLINE : 0))
+			       & dfa->ctx_used);
+    }
+  dfa->class_context[k] = (CONTEXT_BUF | CONTEXT_NEWLINE) & dfa->ctx_used;
+  dfa->class_context[k + 1] = CONTEXT_BUF & dfa->ctx_used;
+  dfa->newline_anchor = newline_anchor;
+}
+
+/* Functions for the required string.  */
+
+/* What is known of the strings a subtree matches: a string each of them
+   starts with, one each ends with, and one each contains.  If EXACT,
+   the subtree matches IN only, which is then LEFT and RIGHT too.  The
+   strings are cut to RE_MUST_MAX bytes.  */
+
+typedef struct
+{
+  unsigned char str[RE_MUST_MAX];
+  Idx len;
+} re_must_str_t;
+
+typedef struct
+{
+  re_must_str_t left, right, in;
+  bool exact;
+} re_must_t;
+
+static void
+must_set_exact (re_must_t *must, const unsigned char *str, Idx len)
+{
+  if (len > 0)
+    memcpy (must->in.str, str, len);
+  must->in.len = len;
+  must->left = must->right = must->in;
+  must->exact = true;
+}
+
+static void
+must_set_none (re_must_t *must)
+{
+  must->left.len = must->right.len = must->in.len = 0;
+  must->exact = false;
+}
+
+/* Set DST to A followed by B, keeping the end of it if too long if
+   KEEP_END, and else the start.  DST may be A or B.  */
+
+static void
+must_cat (re_must_str_t *dst, const re_must_str_t *a, const re_must_str_t *b,
+	  bool keep_end)
+{
+  unsigned char buf[2 * RE_MUST_MAX];
+  Idx len = a->len + b->len;
+  Idx from = keep_end && len > RE_MUST_MAX ? len - RE_MUST_MAX : 0;
+
+  memcpy (buf, a->str, a->len);
+  memcpy (buf + a->len, b->str, b->len);
+  dst->len = len - from < RE_MUST_MAX ? len - from : RE_MUST_MAX;
+  memcpy (dst->str, buf + from, dst->len);
+}
+
+static void
+must_longest (re_must_str_t *dst, const re_must_str_t *src)
+{
+  if (src->len > dst->len)
+    *dst = *src;
+}
+
+/* Set R to what is known of A followed by B.  R may be A or B.  */
+
+static void
+must_concat (re_must_t *r, const re_must_t *a, const re_must_t *b)
+{
+  re_must_str_t mid, in;
+
+  must_cat (&mid, &a->right, &b->left, false);
+  if (a->exact && b->exact && a->in.len + b->in.len <= RE_MUST_MAX)
+    {
+      must_cat (&r->in, &a->in, &b->in, false);
+      r->left = r->right = r->in;
+      r->exact = true;
+      return;
+    }
+  in = a->in;
+  must_longest (&in, &b->in);
+  must_longest (&in, &mid);
+  if (a->exact)
+    must_cat (&r->left, &a->left, &b->left, false);
+  else
+    r->left = a->left;
+  if (b->exact)
+    must_cat (&r->right, &a->right, &b->right, true);
+  else
+    r->right = b->right;
+  r->in = in;
+  must_longest (&r->in, &r->left);
+  must_longest (&r->in, &r->right);
+  r->exact = false;
+}
+
+/* Set R to what is known of A or B.  R may be A or B.  */
+
+static void
+must_alt (re_must_t *r, const re_must_t *a, const re_must_t *b)
+{
+  Idx i;
+
+  if (a->exact && b->exact && a->in.len == b->in.len
+      && memcmp (a->in.str, b->in.str, a->in.len) == 0)
+    {
+      *r = *a;
+      return;
+    }
+  for (i = 0; (i < a->left.len && i < b->left.len
+	       && a->left.str[i] == b->left.str[i]); i++)
+    ;
+  memmove (r->left.str, a->left.str, i);
+  r->left.len = i;
+  for (i = 0; (i < a->right.len && i < b->right.len
+	       && (a->right.str[a->right.len - 1 - i]
+		   == b->right.str[b->right.len - 1 - i])); i++)
+    ;
+  memmove (r->right.str, a->right.str + a->right.len - i, i);
+  r->right.len = i;
+  r->in = r->left;
+  must_longest (&r->in, &r->right);
+  r->exact = false;
+}
+
+/* Find out in MUST what is known of the strings NODE matches.  */
+
+static void
+calc_must_tree (const bin_tree_t *node, re_must_t *must)
+{
+  re_must_t elem;
+  const bin_tree_t *n;
+  Idx i;
+
+  if (node == NULL)
+    {
+      must_set_exact (must, NULL, 0);
+      return;
+    }
+  switch (node->token.type)
+    {
+    case CHARACTER:
+      must_set_exact (must, &node->token.opr.c, 1);
+      break;
+
+    case ANCHOR:
+      must_set_exact (must, NULL, 0);
+      break;
+
+    case SUBEXP:
+      calc_must_tree (node->left, must);
+      break;
+
+    case CONCAT:
+    case OP_ALT:
+      /* The chain leans left, as gen_chain says; go up it from the
+	 last element.  */
+      calc_must_tree (node->right, must);
+      for (n = node->left; n != NULL && n->token.type == node->token.type;
+	   n = n->left)
+	{
+	  calc_must_tree (n->right, &elem);
+	  if (node->token.type == CONCAT)
+	    must_concat (must, &elem, must);
+	  else
+	    must_alt (must, &elem, must);
+	}
+      calc_must_tree (n, &elem);
+      if (node->token.type == CONCAT)
+	must_concat (must, &elem, must);
+      else
+	must_alt (must, &elem, must);
+      break;
+
+    case OP_DUP_ASTERISK:
+      if (node->min == 0)
+	{
+	  must_set_none (must);
+	  break;
+	}
+      calc_must_tree (node->left, &elem);
+      *must = elem;
+      /* Copies past these add nothing that fits.  */
+      for (i = 1; i < node->min && i <= RE_MUST_MAX; i++)
+	must_concat (must, must, &elem);
+      if (node->max != node->min)
+	must->exact = false;
+      break;
+
+    default:
+      must_set_none (must);
+      break;
+    }
+}
+
+/* How common byte C is in text, the more the higher; the byte of the
+   required string that is looked for is picked as rare as can be.  */
+
+static int
+must_byte_rank (unsigned char c)
+{
+  static const char letters[] = "etaoinshrdlcumwfgypbvkjxqz";
+  const char *l;
+
+  if (c == ' ')
+    return 64;
+  if (islower (c) && (l = strchr (letters, c)) != NULL)
+    return 50 - (l - letters);
+  if (isupper (c) && (l = strchr (letters, tolower (c))) != NULL)
+    return 16 - (l - letters) / 2;
+  if (isdigit (c))
+    return 30;
+  if (isprint (c) || c == '\n' || c == '\t')
+    return 8;
+  return 1;
+}
+
+/* Find in DFA, from TREE, a string every match contains, and the byte
+   of it to look for first.  */
+
+static void
+calc_must (re_dfa_t *dfa, const bin_tree_t *tree)
+{
+  re_must_t must;
+  const re_must_str_t *str;
+  Idx i;
+  int ch, best = INT_MAX;
+
+  dfa->must_lines = true;
+  for (i = 0; i < dfa->nsbcsets; i++)
+    if (bitset_contain (dfa->sbcsets[i], '\n'))
+      dfa->must_lines = false;
+
+  calc_must_tree (tree, &must);
+  /* Where every match starts tells more than a longer string.  */
+  dfa->must_prefix = must.left.len > 0 && 2 * must.left.len >= must.in.len;
+  str = dfa->must_prefix ? &must.left : &must.in;
+  memcpy (dfa->must, str->str, str->len);
+  dfa->must_len = str->len;
+  dfa->must_pivot = 0;
+  for (i = 0; i < dfa->must_len; i++)
+    {
+      int score = 0;
+      for (ch = 0; ch < SBC_MAX; ch++)
+	if (dfa->trans[ch] == dfa->must[i])
+	  score += must_byte_rank (ch);
+      if (score < best)
+	{
+	  best = score;
+	  dfa->must_pivot = i;
+	}
+    }
+
+  simd_byteset_init (&dfa->must_set);
+  if (dfa->must_len > 0)
+    for (ch = 0; ch < SBC_MAX; ch++)
+      if (dfa->trans[ch] == dfa->must[dfa->must_pivot])
+	simd_byteset_add (&dfa->must_set, ch);
+}
+
+/* Return the length of the literal string NODE stands for, or -1 if
+   it is not one.  */
+
+static Idx
+literal_length (const bin_tree_t *node)
+{
+  Idx len = 0;
+
+  /* The chain leans left, as gen_chain says.  */
+  for (; node != NULL && node->token.type == CONCAT; node = node->left)
+    {
+      if (node->right == NULL || node->right->token.type != CHARACTER)
+	return -1;
+      len++;
+    }
+  if (node == NULL || node->token.type != CHARACTER)
+    return -1;
+  return len + 1;
+}
+
+/* Copy the literal string NODE stands for, LEN bytes, to BUF.  */
+
+static void
+literal_copy (const bin_tree_t *node, Idx len, unsigned char *buf)
+{
+  for (; node->token.type == CONCAT; node = node->left)
+    buf[--len] = node->right->token.opr.c;
+  buf[--len] = node->token.opr.c;
+}
+
+/* Fill in LIT, whose table has room for a state for each of the TOTAL
+   bytes of the strings of TREE and the root, with the automaton of the
+   strings.  Their bytes are in the classes CLS.  FAIL and BUF are work
+   space.  */
+
+static void
+build_literals (re_literals_t *lit, const bin_tree_t *tree,
+		const unsigned char *cls, Idx total, Idx *fail,
+		unsigned char *buf)
+{
+  const bin_tree_t *n;
+  Idx *trans = lit->trans;
+  Idx *queue = fail + total + 1;
+  Idx row = lit->nclasses + 2;
+  Idx nstates, len, s, t, f, head, tail, i;
+  int c, nclasses = lit->nclasses;
+
+  /* First the trie of the strings, with -1 for no transition.  */
+  memset (trans, -1, (size_t) (total + 1) * row * sizeof (Idx));
+  trans[nclasses] = trans[nclasses + 1] = 0;
+  nstates = 1;
+  for (n = tree; ; n = n->left)
+    {
+      const bin_tree_t *branch = n->token.type == OP_ALT ? n->right : n;
+      len = literal_length (branch);
+      literal_copy (branch, len, buf);
+      for (s = 0, i = 0; i < len; i++)
+	{
+	  Idx *next = &trans[s + cls[buf[i]]];
+	  if (*next < 0)
+	    {
+	      *next = nstates++ * row;
+	      trans[*next + nclasses] = i + 1;
+	      trans[*next + nclasses + 1] = 0;
+	    }
+	  s = *next;
+	}
+      trans[s + nclasses + 1] = len;
+      if (branch == n)
+	break;
+    }
+
+  /* Then, going down the trie breadth first, the transitions that leave
+     it go where they would from the longest suffix of the state in it.
+     That suffix is nearer the root, so its transitions are done.  */
+  head = tail = 0;
+  for (c = 0; c < nclasses; c++)
+    if (trans[c] < 0)
+      trans[c] = 0;
+    else
+      {
+	fail[tail] = 0;
+	queue[tail++] = trans[c];
+      }
+  while (head < tail)
+    {
+      s = queue[head];
+      f = fail[head++];
+      if (trans[s + nclasses + 1] == 0)
+	trans[s + nclasses + 1] = trans[f + nclasses + 1];
+      for (c = 0; c < nclasses; c++)
+	{
+	  t = trans[s + c];
+	  if (t < 0)
+	    trans[s + c] = trans[f + c];
+	  else
+	    {
+	      fail[tail] = trans[f + c];
+	      queue[tail++] = t;
+	    }
+	}
+    }
+  lit->nstates = nstates;
+}
+
+/* If TREE is an alternation of literal strings, build for DFA the
+   automaton that looks for them all at once.  Failing that, as for
+   want of memory, the programs run it as they would any pattern.  */
+
+static void
+calc_literals (re_dfa_t *dfa, const bin_tree_t *tree)
+{
+  re_literals_t *lit;
+  const bin_tree_t *n;
+  unsigned char cls[SBC_MAX];
+  unsigned char *buf;
+  Idx *fail, *trans;
+  Idx total = 0, maxlen = 0, len;
+  int ch, nclasses = 1;
+
+  if (tree == NULL || tree->token.type != OP_ALT)
+    return;
+
+  /* Give each byte that the strings have a class of its own.  The
+     alternation leans left too.  */
+  memset (cls, 0, sizeof cls);
+  for (n = tree; ; n = n->left)
+    {
+      const bin_tree_t *branch = (n != NULL && n->token.type == OP_ALT
+				  ? n->right : n);
+      const bin_tree_t *b;
+      len = literal_length (branch);
+      if (len < 0 || len > IDX_MAX - total - 1)
+	return;
+      total += len;
+      if (maxlen < len)
+	maxlen = len;
+      for (b = branch; ; b = b->left)
+	{
+	  ch = (b->token.type == CONCAT ? b->right : b)->token.opr.c;
+	  if (cls[ch] == 0)
+	    {
+	      if (nclasses > UCHAR_MAX)
+		return;
+	      cls[ch] = nclasses++;
+	    }
+	  if (b->token.type != CONCAT)
+	    break;
+	}
+      if (branch == n)
+	break;
+    }
+  if ((size_t) (total + 1) > RE_LITERALS_MAX / (size_t) (nclasses + 2))
+    return;
+
+  lit = re_malloc (re_literals_t, 1);
+  if (__glibc_unlikely (lit == NULL))
+    return;
+  lit->trans = re_malloc (Idx, (size_t) (total + 1) * (nclasses + 2));
+  fail = re_malloc (Idx, 2 * (size_t) (total + 1));
+  buf = re_malloc (unsigned char, maxlen);
+  if (__glibc_likely (lit->trans != NULL && fail != NULL && buf != NULL))
+    {
+      lit->nclasses = nclasses;
+      lit->maxlen = maxlen;
+      for (ch = 0; ch < SBC_MAX; ch++)
+	lit->byteclass[ch] = cls[dfa->trans[ch]];
+      build_literals (lit, tree, cls, total, fail, buf);
+      trans = re_realloc (lit->trans, Idx,
+			  (size_t) lit->nstates * (nclasses + 2));
+      if (trans != NULL)
+	lit->trans = trans;
+      dfa->literals = lit;
+    }
+  else
+    {
+      re_free (lit->trans);
+      re_free (lit);
+    }
+  re_free (fail);
+  re_free (buf);
+}
+
+/* Work out what DFA needs besides its programs, once they are
+   compiled.  */
+
+static void
+finish_dfa (re_dfa_t *dfa)
+{
+  static const unsigned char anchor_context[] =
+    {
+      [WORD_FIRST] = CONTEXT_WORD, [WORD_LAST] = CONTEXT_WORD,
+      [WORD_DELIM] = CONTEXT_WORD, [NOT_WORD_DELIM] = CONTEXT_WORD,
+      [LINE_FIRST] = CONTEXT_NEWLINE, [LINE_LAST] = CONTEXT_NEWLINE,
+      [BUF_FIRST] = CONTEXT_BUF, [BUF_LAST] = CONTEXT_BUF
+    };
+  Idx i;
+  int ch;
+
+  /* The sets were built from the pattern translated; the matcher looks
+     at the string untranslated.  */
+  if (dfa->has_trans)
+    for (i = 0; i < dfa->nsbcsets; i++)
+      {
+	bitset_t raw;
+	bitset_empty (raw);
+	for (ch = 0; ch < SBC_MAX; ch++)
+	  if (bitset_contain (dfa->sbcsets[i], dfa->trans[ch]))
+	    bitset_set (raw, ch);
+	bitset_copy (dfa->sbcsets[i], raw);
+      }
+
+  for (i = 0; i < dfa->fwd.ninsts; i++)
+    if (dfa->fwd.insts[i].opcode == INST_ANCHOR)
+      dfa->ctx_used |= anchor_context[dfa->fwd.insts[i].arg];
+  calc_byteclasses (dfa);
+  re_dfa_set_context (dfa, dfa->newline_anchor);
+  calc_first (dfa);
+}
+
+/* Compile the programs of DFA from TREE.  */
+
+static reg_errcode_t
+compile_progs (re_dfa_t *dfa, const bin_tree_t *tree)
+{
+  re_compiler_t c;
+  Idx char_sbcset[SBC_MAX];
+  reg_errcode_t err;
+
+  memset (char_sbcset, -1, sizeof char_sbcset);
+  c.dfa = dfa;
+  c.char_sbcset = char_sbcset;
+  calc_literals (dfa, tree);
+  err = compile_prog (&c, &dfa->fwd, tree, false);
+  /* The automaton of literals finds where a match starts itself.  */
+  if (__glibc_likely (err == REG_NOERROR) && dfa->nbackref == 0
+      && dfa->literals == NULL)
+    err = compile_prog (&c, &dfa->rev, tree, true);
+  if (__glibc_unlikely (err != REG_NOERROR))
+    return err;
+  finish_dfa (dfa);
+  calc_must (dfa, tree);
+  return REG_NOERROR;
+}
+
+/* Compile the NTREES trees of a set of patterns into the forward
+   program of DFA: the alternation of them all, each jumping at its end
+   to an INST_MATCH of its own whose argument is its index.  These come
+   last in the program, so that they come last in the states too.  */
+
+static reg_errcode_t
+compile_set_prog (re_dfa_t *dfa, bin_tree_t *const *trees, Idx ntrees)
+{
+  re_prog_t *prog = &dfa->fwd;
+  re_compiler_t c;
+  Idx char_sbcset[SBC_MAX];
+  reg_errcode_t err = REG_NOERROR;
+  Idx *jumps;
+  Idx i, pc;
+
+  memset (char_sbcset, -1, sizeof char_sbcset);
+  c.dfa = dfa;
+  c.char_sbcset = char_sbcset;
+  c.prog = prog;
+  c.alloc = 0;
+  c.reverse = false;
+  jumps = re_malloc (Idx, ntrees + 1);
+  if (__glibc_unlikely (jumps == NULL))
+    return REG_ESPACE;
+
+  pc = emit (&c, INST_SAVE, 0, 0, 0);
+  for (i = 0; i < ntrees && pc >= 0 && err == REG_NOERROR; i++)
+    {
+      Idx alt = -1;
+      if (i + 1 < ntrees)
+	{
+	  pc = alt = emit (&c, INST_ALT, 0, prog->ninsts + 1, -1);
+	  if (pc < 0)
+	    break;
+	}
+      err = gen_tree (&c, trees[i]);
+      if (err == REG_NOERROR)
+	{
+	  pc = jumps[i] = emit (&c, INST_JMP, 0, -1, 0);
+	  if (alt >= 0)
+	    prog->insts[alt].y = prog->ninsts;
+	}
+    }
+  for (i = 0; i < ntrees && pc >= 0 && err == REG_NOERROR; i++)
+    {
+      pc = emit (&c, INST_MATCH, i, 0, 0);
+      if (pc >= 0)
+	prog->insts[jumps[i]].x = pc;
+    }
+  /* An empty set never matches: its only thread goes nowhere.  */
+  if (ntrees == 0 && pc >= 0)
+    pc = emit (&c, INST_JMP, 0, prog->ninsts, 0);
+  re_free (jumps);
+  if (err == REG_NOERROR && pc < 0)
+    err = pc == -1 ? REG_ESPACE : REG_ESIZE;
+  if (__glibc_unlikely (err != REG_NOERROR))
+    return err;
+
+  prog->all_matches = true;
+  err = re_prog_init (prog);
+  if (__glibc_unlikely (err != REG_NOERROR))
+    return err;
+  finish_dfa (dfa);
+  /* A bigger automaton needs more room.  */
+  dfa->cache_max += (size_t) prog->ninsts * 64;
+  return REG_NOERROR;
+}
@@ -1,50 +1,35 @@
-<?xml version="1.0" encoding="utf-8"?>
-<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Strict//EN" "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd">
-<html xmlns="http://www.w3.org/1999/xhtml" xml:lang="en-US" lang="en-US">
-<!-- git web interface version 2.17.1, (C) 2005-2006, Kay Sievers <kay.sievers@vrfy.org>, Christian Gierke -->
-<!-- git core binaries version 2.17.1 -->
-<head>
-<meta http-equiv="content-type" content="text/html; charset=utf-8"/>
-<meta name="generator" content="gitweb/2.17.1 git/2.17.1"/>
-<meta name="robots" content="index, nofollow"/>
-<title>Savannah Git Hosting - gnulib.git/blob_plain - lib/$f</title>
-<link rel="stylesheet" type="text/css" href="/gitweb/static/gitweb.css"/>
-<link rel="shortcut icon" href="/gitweb/static/git-favicon.png" type="image/png" />
-</head>
-<body>
-<div class="page_header">
-<a href="http://git-scm.com/" title="git homepage"><img alt="git" class="logo" height="27" src="/gitweb/static/git-logo.png" width="72" /></a><a href="/gitweb/">git@sv</a> / <a href="/gitweb/?p=gnulib.git;a=summary">gnulib.git</a> / blob_plain
-</div>
-<form method="get" action="/gitweb/" enctype="multipart/form-data"><div class="search">
-<input name="p" type="hidden" value="gnulib.git" />
-<input name="a" type="hidden" value="search" />
-<input name="h" type="hidden" value="HEAD" />
-<select name="st" >
-<option selected="selected" value="commit">commit</option>
-<option value="grep">grep</option>
-<option value="author">author</option>
-<option value="committer">committer</option>
-<option value="pickaxe">pickaxe</option>
-</select> <a href="/gitweb/?p=gnulib.git;a=search_help" title="search help">?</a> search:
-<input type="text" name="s"  />
-<span title="Extended regular expression"><label><input type="checkbox" name="sr" value="1" />re</label></span></div>
-</form>
-<div class="page_body">
-<br /><br />
-404 - Cannot find file
-<br />
-</div>
-<div class="page_footer">
-<div class="page_footer_text">gnulib - GNU portability library</div>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=rss;f=lib/%24f" title="history of lib/$f RSS feed">RSS</a>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=atom;f=lib/%24f" title="history of lib/$f Atom feed">Atom</a>
-</div>
-<script type="text/javascript" src="/gitweb/static/gitweb.js"></script>
-<script type="text/javascript">
-window.onload = function () {
-	var tz_cookie = { name: 'gitweb_tz', expires: 14, path: '/' };
-	onloadTZSetup('local', tz_cookie, 'datetime');
-};
-</script>
-</body>
-</html>
\ No newline at end of file
+/* Extended regular expression matching and search library.
+   Copyright (C) 2002-2023 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+/* The GNU interfaces are always compiled.  */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE 1
+#endif
+
+/* The whole matcher is one translation unit, so that its internal
+   functions can all be static.  Link with obstack.c and simd.c.  */
+
+#include "regex.h"
+#include "regex_internal.h"
+
+#include "regex_internal.c"
+#include "regcomp.c"
+#include "regexec.c"
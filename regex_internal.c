@@ -1,50 +1,191 @@
-<?xml version="1.0" encoding="utf-8"?>
-<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Strict//EN" "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd">
-<html xmlns="http://www.w3.org/1999/xhtml" xml:lang="en-US" lang="en-US">
-<!-- git web interface version 2.17.1, (C) 2005-2006, Kay Sievers <kay.sievers@vrfy.org>, Christian Gierke -->
-<!-- git core binaries version 2.17.1 -->
-<head>
-<meta http-equiv="content-type" content="text/html; charset=utf-8"/>
-<meta name="generator" content="gitweb/2.17.1 git/2.17.1"/>
-<meta name="robots" content="index, nofollow"/>
-<title>Savannah Git Hosting - gnulib.git/blob_plain - lib/$f</title>
-<link rel="stylesheet" type="text/css" href="/gitweb/static/gitweb.css"/>
-<link rel="shortcut icon" href="/gitweb/static/git-favicon.png" type="image/png" />
-</head>
-<body>
-<div class="page_header">
-<a href="http://git-scm.com/" title="git homepage"><img alt="git" class="logo" height="27" src="/gitweb/static/git-logo.png" width="72" /></a><a href="/gitweb/">git@sv</a> / <a href="/gitweb/?p=gnulib.git;a=summary">gnulib.git</a> / blob_plain
-</div>
-<form method="get" action="/gitweb/" enctype="multipart/form-data"><div class="search">
-<input name="p" type="hidden" value="gnulib.git" />
-<input name="a" type="hidden" value="search" />
-<input name="h" type="hidden" value="HEAD" />
-<select name="st" >
-<option selected="selected" value="commit">commit</option>
-<option value="grep">grep</option>
-<option value="author">author</option>
-<option value="committer">committer</option>
-<option value="pickaxe">pickaxe</option>
-</select> <a href="/gitweb/?p=gnulib.git;a=search_help" title="search help">?</a> search:
-<input type="text" name="s"  />
-<span title="Extended regular expression"><label><input type="checkbox" name="sr" value="1" />re</label></span></div>
-</form>
-<div class="page_body">
-<br /><br />
-404 - Cannot find file
-<br />
-</div>
-<div class="page_footer">
-<div class="page_footer_text">gnulib - GNU portability library</div>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=rss;f=lib/%24f" title="history of lib/$f RSS feed">RSS</a>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=atom;f=lib/%24f" title="history of lib/$f Atom feed">Atom</a>
-</div>
-<script type="text/javascript" src="/gitweb/static/gitweb.js"></script>
-<script type="text/javascript">
-window.onload = function () {
-	var tz_cookie = { name: 'gitweb_tz', expires: 14, path: '/' };
-	onloadTZSetup('local', tz_cookie, 'datetime');
-};
-</script>
-</body>
-</html>
\ No newline at end of file
+/* Extended regular expression matching and search library.
+   Copyright (C) 2002-2023 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+static void re_prog_flush (re_prog_t *prog);
+
+/* Functions for programs.  */
+
+/* Prepare PROG, whose instructions are in place, for running: allocate
+   the state cache and the work space for building states.  */
+
+static reg_errcode_t
+re_prog_init (re_prog_t *prog)
+{
+  Idx n = prog->ninsts;
+
+  /* Every thread of a state is a distinct instruction, and every group
+     but the last ends with a mark.  The stack of the closure holds at
+     most two entries for each instruction it visits.  */
+  prog->visited_sparse = re_malloc (Idx, 9 * (size_t) n + 2);
+  if (__glibc_unlikely (prog->visited_sparse == NULL))
+    return REG_ESPACE;
+  prog->visited_dense = prog->visited_sparse + n;
+  prog->next_sparse = prog->visited_dense + n;
+  prog->next_dense = prog->next_sparse + n;
+  prog->stack = prog->next_dense + n;
+  prog->work = prog->stack + 2 * n + 1;
+
+  prog->table_mask = 63;
+  prog->table = calloc (prog->table_mask + 1, sizeof *prog->table);
+  if (__glibc_unlikely (prog->table == NULL))
+    {
+      re_free (prog->visited_sparse);
+      prog->visited_sparse = NULL;
+      return REG_ESPACE;
+    }
+  obstack_begin (&prog->states, 16 * 1024 - 64);
+  prog->first_state = NULL;
+  prog->nstates = 0;
+  prog->nflushes = 0;
+  memset (prog->init, 0, sizeof prog->init);
+  return REG_NOERROR;
+}
+
+static void
+re_prog_free (re_prog_t *prog)
+{
+  if (prog->table != NULL)
+    obstack_free (&prog->states, NULL);
+  re_free (prog->table);
+  re_free (prog->visited_sparse);
+  re_free (prog->insts);
+  prog->table = NULL;
+  prog->visited_sparse = NULL;
+  prog->insts = NULL;
+}
+
+/* Sets of instructions, for building states.  */
+
+static inline bool
+re_prog_visit (re_prog_t *prog, Idx pc)
+{
+  Idx i = prog->visited_sparse[pc];
+  if ((size_t) i < (size_t) prog->nvisited && prog->visited_dense[i] == pc)
+    return false;
+  prog->visited_sparse[pc] = prog->nvisited;
+  prog->visited_dense[prog->nvisited++] = pc;
+  return true;
+}
+
+static inline bool
+re_prog_add_next (re_prog_t *prog, Idx pc)
+{
+  Idx i = prog->next_sparse[pc];
+  if ((size_t) i < (size_t) prog->nnext && prog->next_dense[i] == pc)
+    return false;
+  prog->next_sparse[pc] = prog->nnext;
+  prog->next_dense[prog->nnext++] = pc;
+  return true;
+}
+
+/* Functions for the state cache.  */
+
+static re_hashval_t
+calc_state_hash (const Idx *nodes, Idx nnodes, unsigned int flags)
+{
+  re_hashval_t hash = nnodes + flags * 0x9e3779b9u;
+  Idx i;
+  for (i = 0; i < nnodes; ++i)
+    hash = (hash ^ (re_hashval_t) nodes[i]) * 0x01000193u;
+  return hash ^ (hash >> 15);
+}
+
+static void
+re_prog_grow_table (re_prog_t *prog)
+{
+  size_t mask = prog->table_mask * 2 + 1;
+  re_dfastate_t **table = calloc (mask + 1, sizeof *table);
+  size_t i;
+
+  /* A crowded table is only slower.  */
+  if (table == NULL)
+    return;
+  for (i = 0; i <= prog->table_mask; i++)
+    while (prog->table[i] != NULL)
+      {
+	re_dfastate_t *state = prog->table[i];
+	prog->table[i] = state->next;
+	state->next = table[state->hash & mask];
+	table[state->hash & mask] = state;
+      }
+  re_free (prog->table);
+  prog->table = table;
+  prog->table_mask = mask;
+}
+
+/* Forget every state of PROG.  The caller must not use any it holds.  */
+
+static void
+re_prog_flush (re_prog_t *prog)
+{
+  if (prog->first_state != NULL)
+    obstack_free (&prog->states, prog->first_state);
+  prog->first_state = NULL;
+  memset (prog->table, 0, (prog->table_mask + 1) * sizeof *prog->table);
+  memset (prog->init, 0, sizeof prog->init);
+  prog->nstates = 0;
+  prog->nflushes++;
+}
+
+/* Return the state of PROG with the NNODES threads in NODES and FLAGS,
+   creating it if it is new.  This may flush the cache to make room.
+   Return NULL if there is no memory even then.  */
+
+static re_dfastate_t *
+re_acquire_state (re_dfa_t *dfa, re_prog_t *prog,
+		  const Idx *nodes, Idx nnodes, unsigned int flags)
+{
+  re_hashval_t hash = calc_state_hash (nodes, nnodes, flags);
+  size_t ntrans = dfa->nclasses + 2;
+  size_t size;
+  re_dfastate_t *state;
+
+  for (state = prog->table[hash & prog->table_mask]; state != NULL;
+       state = state->next)
+    if (state->hash == hash && state->flags == flags
+	&& state->nnodes == nnodes
+	&& memcmp (state->nodes, nodes, nnodes * sizeof (Idx)) == 0)
+      return state;
+
+  size = (sizeof (re_dfastate_t) + ntrans * sizeof (re_dfastate_t *)
+	  + nnodes * sizeof (Idx));
+  if (prog->nstates != 0
+      && obstack_memory_used (&prog->states) > dfa->cache_max)
+    re_prog_flush (prog);
+  state = obstack_try_alloc (&prog->states, size);
+  if (state == NULL && prog->nstates != 0)
+    {
+      re_prog_flush (prog);
+      state = obstack_try_alloc (&prog->states, size);
+    }
+  if (__glibc_unlikely (state == NULL))
+    return NULL;
+  if (prog->first_state == NULL)
+    prog->first_state = state;
+
+  state->hash = hash;
+  state->flags = flags;
+  state->nnodes = nnodes;
+  memset (state->trans, 0, ntrans * sizeof (re_dfastate_t *));
+  state->nodes = (Idx *) &state->trans[ntrans];
+  memcpy (state->nodes, nodes, nnodes * sizeof (Idx));
+  state->next = prog->table[hash & prog->table_mask];
+  prog->table[hash & prog->table_mask] = state;
+  if (++prog->nstates > prog->table_mask)
+    re_prog_grow_table (prog);
+  return state;
+}
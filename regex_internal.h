@@ -1,50 +1,489 @@
-<?xml version="1.0" encoding="utf-8"?>
-<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Strict//EN" "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd">
-<html xmlns="http://www.w3.org/1999/xhtml" xml:lang="en-US" lang="en-US">
-<!-- git web interface version 2.17.1, (C) 2005-2006, Kay Sievers <kay.sievers@vrfy.org>, Christian Gierke -->
-<!-- git core binaries version 2.17.1 -->
-<head>
-<meta http-equiv="content-type" content="text/html; charset=utf-8"/>
-<meta name="generator" content="gitweb/2.17.1 git/2.17.1"/>
-<meta name="robots" content="index, nofollow"/>
-<title>Savannah Git Hosting - gnulib.git/blob_plain - lib/$f</title>
-<link rel="stylesheet" type="text/css" href="/gitweb/static/gitweb.css"/>
-<link rel="shortcut icon" href="/gitweb/static/git-favicon.png" type="image/png" />
-</head>
-<body>
-<div class="page_header">
-<a href="http://git-scm.com/" title="git homepage"><img alt="git" class="logo" height="27" src="/gitweb/static/git-logo.png" width="72" /></a><a href="/gitweb/">git@sv</a> / <a href="/gitweb/?p=gnulib.git;a=summary">gnulib.git</a> / blob_plain
-</div>
-<form method="get" action="/gitweb/" enctype="multipart/form-data"><div class="search">
-<input name="p" type="hidden" value="gnulib.git" />
-<input name="a" type="hidden" value="search" />
-<input name="h" type="hidden" value="HEAD" />
-<select name="st" >
-<option selected="selected" value="commit">commit</option>
-<option value="grep">grep</option>
-<option value="author">author</option>
-<option value="committer">committer</option>
-<option value="pickaxe">pickaxe</option>
-</select> <a href="/gitweb/?p=gnulib.git;a=search_help" title="search help">?</a> search:
-<input type="text" name="s"  />
-<span title="Extended regular expression"><label><input type="checkbox" name="sr" value="1" />re</label></span></div>
-</form>
-<div class="page_body">
-<br /><br />
-404 - Cannot find file
-<br />
-</div>
-<div class="page_footer">
-<div class="page_footer_text">gnulib - GNU portability library</div>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=rss;f=lib/%24f" title="history of lib/$f RSS feed">RSS</a>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=atom;f=lib/%24f" title="history of lib/$f Atom feed">Atom</a>
-</div>
-<script type="text/javascript" src="/gitweb/static/gitweb.js"></script>
-<script type="text/javascript">
-window.onload = function () {
-	var tz_cookie = { name: 'gitweb_tz', expires: 14, path: '/' };
-	onloadTZSetup('local', tz_cookie, 'datetime');
+/* Extended regular expression matching and search library.
+   Copyright (C) 2002-2023 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+#ifndef _REGEX_INTERNAL_H
+#define _REGEX_INTERNAL_H 1
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <pthread.h>
+
+#include "obstack.h"
+#include "simd.h"
+
+#define lock_define(name) pthread_mutex_t name;
+#define lock_init(lock) pthread_mutex_init (&(lock), 0)
+#define lock_fini(lock) ((void) pthread_mutex_destroy (&(lock)))
+#define lock_lock(lock) ((void) pthread_mutex_lock (&(lock)))
+#define lock_unlock(lock) ((void) pthread_mutex_unlock (&(lock)))
+
+#define obstack_chunk_alloc malloc
+#define obstack_chunk_free free
+
+#ifndef gettext
+# define gettext(msgid) (msgid)
+#endif
+
+#ifndef gettext_noop
+/* This define is so xgettext can find the internationalizable
+   strings.  */
+# define gettext_noop(String) String
+#endif
+
+#ifndef __glibc_likely
+# define __glibc_likely(cond) __builtin_expect ((cond), 1)
+# define __glibc_unlikely(cond) __builtin_expect ((cond), 0)
+#endif
+
+#ifndef FALLTHROUGH
+# if defined __GNUC__ && 7 <= __GNUC__
+#  define FALLTHROUGH __attribute__ ((__fallthrough__))
+# else
+#  define FALLTHROUGH ((void) 0)
+# endif
+#endif
+
+/* Number of ASCII characters.  */
+#define ASCII_CHARS 0x80
+
+/* Number of single byte characters.  */
+#define SBC_MAX (UCHAR_MAX + 1)
+
+/* Type for indexes into the pattern, the string and the program.  */
+#ifdef _REGEX_LARGE_OFFSETS
+typedef ssize_t Idx;
+# define IDX_MAX SSIZE_MAX
+#else
+typedef int Idx;
+# define IDX_MAX INT_MAX
+#endif
+
+/* A hash value, suitable for computing hash tables.  */
+typedef __re_size_t re_hashval_t;
+
+/* An integer used to represent a set of bits.  It must be unsigned,
+   and must be at least as wide as unsigned int.  */
+typedef unsigned long int bitset_word_t;
+/* All bits set in a bitset_word_t.  */
+#define BITSET_WORD_MAX ULONG_MAX
+/* Number of bits in a bitset_word_t.  */
+#define BITSET_WORD_BITS (sizeof (bitset_word_t) * CHAR_BIT)
+/* Number of bitset_word_t values in a bitset_t.  */
+#define BITSET_WORDS ((SBC_MAX + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS)
+
+typedef bitset_word_t bitset_t[BITSET_WORDS];
+typedef bitset_word_t *re_bitset_ptr_t;
+typedef const bitset_word_t *re_const_bitset_ptr_t;
+
+#define NEWLINE_CHAR '\n'
+#define IS_WORD_CHAR(ch) (isalnum (ch) || (ch) == '_')
+
+/* The pattern being compiled, read through the translation table.  */
+typedef struct
+{
+  const unsigned char *raw_mbs;
+  Idx len;
+  Idx cur_idx;
+  /* The translation of each byte, or NULL for none.  It folds case
+     if RE_ICASE is set.  */
+  const unsigned char *trans;
+} re_string_t;
+
+#define re_string_peek_byte_case(pstr, offset) \
+  ((pstr)->raw_mbs[(pstr)->cur_idx + (offset)])
+#define re_string_peek_byte(pstr, offset) \
+  ((pstr)->trans \
+   ? (pstr)->trans[re_string_peek_byte_case (pstr, offset)] \
+   : re_string_peek_byte_case (pstr, offset))
+#define re_string_fetch_byte_case(pstr) \
+  ((pstr)->raw_mbs[(pstr)->cur_idx++])
+#define re_string_fetch_byte(pstr) \
+  ((pstr)->trans \
+   ? (pstr)->trans[re_string_fetch_byte_case (pstr)] \
+   : re_string_fetch_byte_case (pstr))
+#define re_string_cur_idx(pstr) ((pstr)->cur_idx)
+#define re_string_length(pstr) ((pstr)->len)
+#define re_string_eoi(pstr) ((pstr)->cur_idx >= (pstr)->len)
+#define re_string_skip_bytes(pstr, idx) ((pstr)->cur_idx += (idx))
+#define re_string_set_index(pstr, idx) ((pstr)->cur_idx = (idx))
+
+typedef enum
+{
+  NON_TYPE = 0,
+
+  /* Node type, These are used by token, node, tree.  */
+  CHARACTER = 1,
+  END_OF_RE = 2,
+  SIMPLE_BRACKET = 3,
+  OP_BACK_REF = 4,
+  OP_PERIOD = 5,
+  ANCHOR = 6,
+
+  /* We define EPSILON_BIT as a macro so that OP_OPEN_SUBEXP is used
+     when the debugger shows values of this enum type.  */
+#define EPSILON_BIT 8
+  OP_ALT = EPSILON_BIT | 2,
+  OP_DUP_ASTERISK = EPSILON_BIT | 3,
+
+  /* Tree type, these are used only by tree. */
+  CONCAT = 16,
+  SUBEXP = 17,
+
+  /* Token type, these are used only by token.  */
+  OP_DUP_PLUS = 18,
+  OP_DUP_QUESTION,
+  OP_OPEN_SUBEXP,
+  OP_CLOSE_SUBEXP,
+  OP_OPEN_BRACKET,
+  OP_CLOSE_BRACKET,
+  OP_CHARSET_RANGE,
+  OP_OPEN_DUP_NUM,
+  OP_CLOSE_DUP_NUM,
+  OP_NON_MATCH_LIST,
+  OP_OPEN_COLL_ELEM,
+  OP_CLOSE_COLL_ELEM,
+  OP_OPEN_EQUIV_CLASS,
+  OP_CLOSE_EQUIV_CLASS,
+  OP_OPEN_CHAR_CLASS,
+  OP_CLOSE_CHAR_CLASS,
+  OP_WORD,
+  OP_NOTWORD,
+  OP_SPACE,
+  OP_NOTSPACE,
+  BACK_SLASH
+} re_token_type_t;
+
+/* What an ANCHOR requires of the bytes on either side of it.  */
+typedef enum
+{
+  WORD_FIRST,                   /* \< */
+  WORD_LAST,                    /* \> */
+  WORD_DELIM,                   /* \b */
+  NOT_WORD_DELIM,               /* \B */
+  LINE_FIRST,                   /* ^ */
+  LINE_LAST,                    /* $ */
+  BUF_FIRST,                    /* \` */
+  BUF_LAST                      /* \' */
+} re_context_type;
+
+/* The context of a position, as seen from one side: whether the byte
+   there is a word character, whether it starts or ends a line, and
+   whether it is outside the string.  */
+#define CONTEXT_WORD 1
+#define CONTEXT_NEWLINE (CONTEXT_WORD << 1)
+#define CONTEXT_BUF (CONTEXT_NEWLINE << 1)
+#define CONTEXT_ALL (CONTEXT_WORD | CONTEXT_NEWLINE | CONTEXT_BUF)
+
+typedef struct
+{
+  union
+  {
+    unsigned char c;            /* for CHARACTER */
+    Idx idx;                    /* for OP_BACK_REF, SUBEXP, SIMPLE_BRACKET */
+    re_context_type ctx_type;   /* for ANCHOR */
+  } opr;
+  re_token_type_t type;
+} re_token_t;
+
+/* Type of an element of a bracket expression.  */
+typedef enum
+{
+  SB_CHAR,
+  EQUIV_CLASS,
+  COLL_SYM,
+  CHAR_CLASS
+} bracket_elem_type;
+
+typedef struct
+{
+  bracket_elem_type type;
+  union
+  {
+    unsigned char ch;
+    unsigned char *name;
+  } opr;
+} bracket_elem_t;
+
+typedef struct bin_tree_t
+{
+  struct bin_tree_t *left;
+  struct bin_tree_t *right;
+  re_token_t token;
+  /* For OP_DUP_ASTERISK, the bounds of the repetition; MAX is -1 for
+     no limit.  */
+  Idx min;
+  Idx max;
+} bin_tree_t;
+
+/* Instructions of a compiled program.  Each instruction but INST_ALT
+   and INST_JMP goes on to the one after it.  */
+typedef enum
+{
+  INST_CHARSET,                 /* a byte in sbcsets[ARG] */
+  INST_ALT,                     /* go on at X and at Y, preferring X */
+  INST_JMP,                     /* go on at X */
+  INST_SAVE,                    /* record the position in register ARG */
+  INST_ANCHOR,                  /* nothing, if constraint ARG holds */
+  INST_BACKREF,                 /* what subexpression ARG matched */
+  INST_MATCH                    /* the end of a match */
+} re_opcode_t;
+
+typedef struct
+{
+  unsigned char opcode;
+  Idx arg;
+  Idx x;
+  Idx y;
+} re_inst_t;
+
+/* A state of a lazily built DFA.  It is a set of threads of the NFA
+   at some position in the string, each given by the instruction it is
+   about to run; the empty-width instructions reached from them are
+   followed only when the next byte is known.  Threads whose match
+   started earlier come first, and those that started at the same
+   position form a group, ended by NODE_MARK.  */
+typedef struct re_dfastate_t re_dfastate_t;
+struct re_dfastate_t
+{
+  re_hashval_t hash;
+  unsigned int flags;
+  Idx nnodes;
+  Idx *nodes;
+  re_dfastate_t *next;          /* in the same hash bucket */
+  /* The state after each byte class and after the two ends of the
+     string, or NULL if not built yet.  */
+  re_dfastate_t *trans[];
 };
-</script>
-</body>
-</html>
\ No newline at end of file
+
+#define NODE_MARK ((Idx) -1)
+
+/* Flags of a state, above the context of the byte before it.  */
+#define STATE_START 0x08        /* a thread starts at every position */
+#define STATE_MATCH 0x10        /* a match ended before the byte that
+				   led here */
+#define STATE_DEAD 0x20         /* no thread is left */
+#define STATE_INITIAL 0x40      /* no thread but the one started here */
+#define STATE_SPECIAL (STATE_MATCH | STATE_DEAD | STATE_INITIAL)
+
+/* The state cache of a DFA is flushed when it holds more than this
+   many bytes.  */
+#ifndef RE_DFA_CACHE_MAX
+# define RE_DFA_CACHE_MAX (2 * 1024 * 1024)
+#endif
+
+/* The string every match contains is cut to this many bytes.  */
+#ifndef RE_MUST_MAX
+# define RE_MUST_MAX 32
+#endif
+
+/* A compiled program with its DFA.  */
+typedef struct
+{
+  re_inst_t *insts;
+  Idx ninsts;
+  /* Whether the program is of a set of patterns, each ending in an
+     INST_MATCH of its own: then its DFA follows every thread to the
+     end instead of the leftmost match only.  */
+  bool all_matches;
+
+  struct obstack states;
+  re_dfastate_t *first_state;   /* the oldest state in STATES, if any */
+  re_dfastate_t **table;
+  size_t table_mask;
+  size_t nstates;
+  size_t nflushes;
+  /* The start states, anchored or not, by context.  */
+  re_dfastate_t *init[2][CONTEXT_ALL + 1];
+
+  /* Work space for building states.  */
+  Idx *visited_sparse;
+  Idx *visited_dense;
+  Idx nvisited;
+  Idx *next_sparse;
+  Idx *next_dense;
+  Idx nnext;
+  Idx *stack;
+  Idx *work;
+} re_prog_t;
+
+/* The automaton of Aho and Corasick, with every transition filled in,
+   of a pattern that is an alternation of literal strings.  */
+typedef struct
+{
+  /* A row for each state: where each byte class leads, as the index of
+     the row of the state there, then the length of the string the state
+     stands for and the length of the longest literal it ends with, or
+     0.  The root, where no string has begun, is the row at 0.  */
+  Idx *trans;
+  Idx nstates;
+  Idx maxlen;
+  /* The class of each byte of the string, through the translation.  */
+  unsigned char byteclass[SBC_MAX];
+  int nclasses;
+} re_literals_t;
+
+/* The automaton of the literals has at most this many transitions;
+   alternations too big for it are run as any other pattern.  */
+#ifndef RE_LITERALS_MAX
+# define RE_LITERALS_MAX (1 << 24)
+#endif
+
+struct re_dfa_t
+{
+  /* The pattern, and the pattern backwards for finding where a match
+     starts from where it ends.  */
+  re_prog_t fwd;
+  re_prog_t rev;
+
+  bitset_t *sbcsets;
+  Idx nsbcsets;
+  Idx sbcsets_alloc;
+
+  /* Bytes that no instruction tells apart share a class.  Two more
+     classes stand for the ends of the string, with and without a line
+     boundary there.  */
+  unsigned char byteclass[SBC_MAX];
+  unsigned char class_byte[SBC_MAX];
+  unsigned char class_context[SBC_MAX + 2];
+  int nclasses;
+
+  /* The contexts the anchors in the pattern look at, and the value of
+     newline_anchor that CLASS_CONTEXT reflects.  */
+  unsigned int ctx_used;
+  bool newline_anchor;
+
+  /* Translation applied to the pattern and the string.  */
+  unsigned char trans[SBC_MAX];
+  bool has_trans;
+
+  /* The bytes a match can start with, also as a set to look for them
+     with, and whether a match can be empty.  */
+  bitset_t firstset;
+  struct simd_byteset first_scan;
+  bool can_be_null;
+
+  /* A string every match contains, translated, or none if MUST_LEN is
+     0; whether every match starts with it; and the bytes that translate
+     to its byte MUST_PIVOT, which are looked for first.  */
+  unsigned char must[RE_MUST_MAX];
+  Idx must_len;
+  Idx must_pivot;
+  bool must_prefix;
+  struct simd_byteset must_set;
+  /* Whether no match can span a newline.  */
+  bool must_lines;
+
+  /* If the pattern is an alternation of literal strings, what finds
+     them instead of the programs, or NULL.  */
+  re_literals_t *literals;
+
+  /* Whether a search wants the match that ends first, and of those the
+     leftmost, rather than the leftmost-longest.  */
+  bool earliest;
+
+  Idx nbackref;
+  unsigned int completed_bkref_map;
+  /* For a set of patterns, each pattern with backreferences compiled
+     alone, or null.  */
+  regex_t **set_verify;
+  Idx set_npatterns;
+  struct obstack *trees;        /* while compiling */
+  size_t cache_max;
+
+  lock_define (lock)
+};
+
+typedef struct re_dfa_t re_dfa_t;
+
+/* Functions for bitset_t operation.  */
+
+static inline void
+bitset_set (bitset_t set, Idx i)
+{
+  set[i / BITSET_WORD_BITS] |= (bitset_word_t) 1 << i % BITSET_WORD_BITS;
+}
+
+static inline void
+bitset_clear (bitset_t set, Idx i)
+{
+  set[i / BITSET_WORD_BITS] &= ~ ((bitset_word_t) 1 << i % BITSET_WORD_BITS);
+}
+
+static inline bool
+bitset_contain (const bitset_t set, Idx i)
+{
+  return (set[i / BITSET_WORD_BITS] >> i % BITSET_WORD_BITS) & 1;
+}
+
+static inline void
+bitset_empty (bitset_t set)
+{
+  memset (set, '\0', sizeof (bitset_t));
+}
+
+static inline void
+bitset_set_all (bitset_t set)
+{
+  memset (set, -1, sizeof (bitset_word_t) * (SBC_MAX / BITSET_WORD_BITS));
+  if (SBC_MAX % BITSET_WORD_BITS != 0)
+    set[BITSET_WORDS - 1] =
+      ((bitset_word_t) 1 << SBC_MAX % BITSET_WORD_BITS) - 1;
+}
+
+static inline void
+bitset_copy (bitset_t dest, const bitset_t src)
+{
+  memcpy (dest, src, sizeof (bitset_t));
+}
+
+static inline void
+bitset_not (bitset_t set)
+{
+  int bitset_i;
+  for (bitset_i = 0; bitset_i < SBC_MAX / BITSET_WORD_BITS; ++bitset_i)
+    set[bitset_i] = ~set[bitset_i];
+  if (SBC_MAX % BITSET_WORD_BITS != 0)
+    set[BITSET_WORDS - 1] =
+      ((((bitset_word_t) 1 << SBC_MAX % BITSET_WORD_BITS) - 1)
+       & ~set[BITSET_WORDS - 1]);
+}
+
+static inline void
+bitset_merge (bitset_t dest, const bitset_t src)
+{
+  int bitset_i;
+  for (bitset_i = 0; bitset_i < BITSET_WORDS; ++bitset_i)
+    dest[bitset_i] |= src[bitset_i];
+}
+
+static inline bool
+bitset_equal (const bitset_t a, const bitset_t b)
+{
+  return memcmp (a, b, sizeof (bitset_t)) == 0;
+}
+
+#define re_malloc(t,n) ((t *) malloc ((n) * sizeof (t)))
+#define re_realloc(p,t,n) ((t *) realloc (p, (n) * sizeof (t)))
+#define re_free(p) free (p)
+
+#endif /*  _REGEX_INTERNAL_H */
@@ -1,50 +1,1796 @@
-<?xml version="1.0" encoding="utf-8"?>
-<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Strict//EN" "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd">
-<html xmlns="http://www.w3.org/1999/xhtml" xml:lang="en-US" lang="en-US">
-<!-- git web interface version 2.17.1, (C) 2005-2006, Kay Sievers <kay.sievers@vrfy.org>, Christian Gierke -->
-<!-- git core binaries version 2.17.1 -->
-<head>
-<meta http-equiv="content-type" content="text/html; charset=utf-8"/>
-<meta name="generator" content="gitweb/2.17.1 git/2.17.1"/>
-<meta name="robots" content="index, nofollow"/>
-<title>Savannah Git Hosting - gnulib.git/blob_plain - lib/$f</title>
-<link rel="stylesheet" type="text/css" href="/gitweb/static/gitweb.css"/>
-<link rel="shortcut icon" href="/gitweb/static/git-favicon.png" type="image/png" />
-</head>
-<body>
-<div class="page_header">
-<a href="http://git-scm.com/" title="git homepage"><img alt="git" class="logo" height="27" src="/gitweb/static/git-logo.png" width="72" /></a><a href="/gitweb/">git@sv</a> / <a href="/gitweb/?p=gnulib.git;a=summary">gnulib.git</a> / blob_plain
-</div>
-<form method="get" action="/gitweb/" enctype="multipart/form-data"><div class="search">
-<input name="p" type="hidden" value="gnulib.git" />
-<input name="a" type="hidden" value="search" />
-<input name="h" type="hidden" value="HEAD" />
-<select name="st" >
-<option selected="selected" value="commit">commit</option>
-<option value="grep">grep</option>
-<option value="author">author</option>
-<option value="committer">committer</option>
-<option value="pickaxe">pickaxe</option>
-</select> <a href="/gitweb/?p=gnulib.git;a=search_help" title="search help">?</a> search:
-<input type="text" name="s"  />
-<span title="Extended regular expression"><label><input type="checkbox" name="sr" value="1" />re</label></span></div>
-</form>
-<div class="page_body">
-<br /><br />
-404 - Cannot find file
-<br />
-</div>
-<div class="page_footer">
-<div class="page_footer_text">gnulib - GNU portability library</div>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=rss;f=lib/%24f" title="history of lib/$f RSS feed">RSS</a>
-<a class="rss_logo" href="/gitweb/?p=gnulib.git;a=atom;f=lib/%24f" title="history of lib/$f Atom feed">Atom</a>
-</div>
-<script type="text/javascript" src="/gitweb/static/gitweb.js"></script>
-<script type="text/javascript">
-window.onload = function () {
-	var tz_cookie = { name: 'gitweb_tz', expires: 14, path: '/' };
-	onloadTZSetup('local', tz_cookie, 'datetime');
-};
-</script>
-</body>
-</html>
\ No newline at end of file
+/* Extended regular expression matching and search library.
+   Copyright (C) 2002-2023 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Searching runs the DFA of the program forwards to find where the
+   leftmost-longest match ends, then the DFA of the reversed program
+   backwards from there to find where it starts.  Only if subexpressions
+   are wanted does a slower NFA simulation (a Pike VM) run over the
+   match to place them.  Backreferences take a backtracking matcher; the
+   DFA, treating a backreference as matching anything, only rules out
+   strings with no match at all.  A pattern compiled for the earliest
+   match stops the forward scan at the first position where any match
+   ends.  */
+
+static reg_errcode_t re_search_internal (const regex_t *preg,
+					 const char *string, Idx length,
+					 Idx start, Idx last_start, Idx stop,
+					 size_t nmatch, regmatch_t pmatch[],
+					 int eflags);
+static regoff_t re_search_2_stub (struct re_pattern_buffer *bufp,
+				  const char *string1, Idx length1,
+				  const char *string2, Idx length2,
+				  Idx start, regoff_t range,
+				  struct re_registers *regs,
+				  Idx stop, bool ret_len);
+static regoff_t re_search_stub (struct re_pattern_buffer *bufp,
+				const char *string, Idx length, Idx start,
+				regoff_t range, Idx stop,
+				struct re_registers *regs,
+				bool ret_len);
+static unsigned re_copy_regs (struct re_registers *regs, regmatch_t *pmatch,
+			      Idx nregs, int regs_allocated);
+static Idx dfa_scan_set (re_dfa_t *dfa, const unsigned char *string,
+			 Idx length, int eflags, char *matched, Idx npatterns);
+
+/* Results of the scanning functions besides a position.  */
+#define SCAN_NOMATCH ((Idx) -1)
+#define SCAN_ESPACE ((Idx) -2)
+#define SCAN_THRASH ((Idx) -3)
+
+/* Entry point for POSIX code.  */
+
+/* regexec searches for a given pattern, specified by PREG, in the
+   string STRING.
+
+   If NMATCH is zero or REG_NOSUB was set in the cflags argument to
+   'regcomp', we ignore PMATCH.  Otherwise, we assume PMATCH has at
+   least NMATCH elements, and we set them to the offsets of the
+   corresponding matched substrings.
+
+   EFLAGS specifies "execution flags" which affect matching: if
+   REG_NOTBOL is set, then ^ does not match at the beginning of the
+   string; if REG_NOTEOL is set, then $ does not match at the end.
+
+   Return 0 if a match is found, REG_NOMATCH if not, REG_BADPAT if
+   EFLAGS is invalid.  */
+
+int
+regexec (const regex_t *__restrict preg, const char *__restrict string,
+	 size_t nmatch, regmatch_t pmatch[_REGEX_NELTS (nmatch)], int eflags)
+{
+  reg_errcode_t err;
+  Idx start, length;
+  re_dfa_t *dfa = preg->buffer;
+
+  if (eflags & ~(REG_NOTBOL | REG_NOTEOL | REG_STARTEND))
+    return REG_BADPAT;
+
+  if (eflags & REG_STARTEND)
+    {
+      start = pmatch[0].rm_so;
+      length = pmatch[0].rm_eo;
+    }
+  else
+    {
+      start = 0;
+      length = strlen (string);
+    }
+
+  lock_lock (dfa->lock);
+  if (preg->no_sub)
+    err = re_search_internal (preg, string, length, start, length,
+			      length, 0, NULL, eflags);
+  else
+    err = re_search_internal (preg, string, length, start, length,
+			      length, nmatch, pmatch, eflags);
+  lock_unlock (dfa->lock);
+  return err != REG_NOERROR;
+}
+
+/* Entry point for sets of patterns.  */
+
+/* regsetexec searches the LENGTH bytes of STRING for all the patterns
+   of SET in one pass of their DFA, and sets MATCHED[I] to whether
+   pattern I matches.  A pattern with backreferences that the DFA finds
+   is searched for again alone, to make sure.
+
+   Return 0 if some pattern matches, REG_NOMATCH if none does, and
+   REG_BADPAT if EFLAGS is invalid.  */
+
+int
+regsetexec (const regset_t *__restrict set, const char *__restrict string,
+	    size_t length, char matched[], int eflags)
+{
+  re_dfa_t *dfa = set->buffer;
+  Idx npatterns = set->re_npatterns;
+  Idx nmatched, i;
+
+  if (eflags & ~(REG_NOTBOL | REG_NOTEOL))
+    return REG_BADPAT;
+  if (__glibc_unlikely (length > IDX_MAX))
+    return REG_ESIZE;
+
+  memset (matched, 0, npatterns);
+  if (npatterns == 0)
+    return REG_NOMATCH;
+  lock_lock (dfa->lock);
+  nmatched = dfa_scan_set (dfa, (const unsigned char *) string, length,
+			   eflags, matched, npatterns);
+  lock_unlock (dfa->lock);
+  if (__glibc_unlikely (nmatched == SCAN_ESPACE))
+    return REG_ESPACE;
+
+  for (i = 0; i < npatterns; i++)
+    if (matched[i] && dfa->set_verify[i] != NULL)
+      {
+	regmatch_t range;
+	int err;
+	range.rm_so = 0;
+	range.rm_eo = length;
+	err = regexec (dfa->set_verify[i], string, 1, &range,
+		       eflags | REG_STARTEND);
+	if (err == REG_NOMATCH)
+	  {
+	    matched[i] = 0;
+	    nmatched--;
+	  }
+	else if (__glibc_unlikely (err != REG_NOERROR))
+	  return err;
+      }
+  return nmatched != 0 ? REG_NOERROR : REG_NOMATCH;
+}
+
+/* Entry points for GNU code.  */
+
+/* re_match, re_search, re_match_2, re_search_2
+
+   The former two functions operate on STRING with length LENGTH,
+   while the later two operate on concatenation of STRING1 and STRING2
+   with lengths LENGTH1 and LENGTH2, respectively.
+
+   re_match() matches the compiled pattern in BUFP against the string,
+   starting at index START.
+
+   re_search() first tries matching at index START, then it tries to match
+   starting from index START + 1, and so on.  The last start position tried
+   is START + RANGE.  (Thus RANGE = 0 forces re_search to operate the same
+   way as re_match().)
+
+   The parameter STOP of re_{match,search}_2 specifies that no match exceeding
+   the first STOP characters of the concatenation of the strings should be
+   concerned.
+
+   If REGS is not NULL, and BUFP->no_sub is not set, the offsets of the match
+   and all groups is stored in REGS.  (For the "_2" variants, the offsets are
+   computed relative to the concatenation, not relative to the individual
+   strings.)
+
+   On success, re_match* functions return the length of the match, re_search*
+   return the position of the start of the match.  They return -1 on
+   match failure, -2 on error.  */
+
+regoff_t
+re_match (struct re_pattern_buffer *bufp, const char *string, Idx length,
+	  Idx start, struct re_registers *regs)
+{
+  return re_search_stub (bufp, string, length, start, 0, length, regs, true);
+}
+
+regoff_t
+re_search (struct re_pattern_buffer *bufp, const char *string, Idx length,
+	   Idx start, regoff_t range, struct re_registers *regs)
+{
+  return re_search_stub (bufp, string, length, start, range, length, regs,
+			 false);
+}
+
+regoff_t
+re_match_2 (struct re_pattern_buffer *bufp, const char *string1, Idx length1,
+	    const char *string2, Idx length2, Idx start,
+	    struct re_registers *regs, Idx stop)
+{
+  return re_search_2_stub (bufp, string1, length1, string2, length2,
+			   start, 0, regs, stop, true);
+}
+
+regoff_t
+re_search_2 (struct re_pattern_buffer *bufp, const char *string1, Idx length1,
+	     const char *string2, Idx length2, Idx start, regoff_t range,
+	     struct re_registers *regs, Idx stop)
+{
+  return re_search_2_stub (bufp, string1, length1, string2, length2,
+			   start, range, regs, stop, false);
+}
+
+static regoff_t
+re_search_2_stub (struct re_pattern_buffer *bufp, const char *string1,
+		  Idx length1, const char *string2, Idx length2, Idx start,
+		  regoff_t range, struct re_registers *regs,
+		  Idx stop, bool ret_len)
+{
+  const char *str;
+  regoff_t rval;
+  Idx len;
+  char *s = NULL;
+
+  if (__glibc_unlikely ((length1 < 0 || length2 < 0 || stop < 0
+			 || __builtin_add_overflow (length1, length2, &len))))
+    return -2;
+
+  /* Concatenate the strings.  */
+  if (length2 > 0)
+    if (length1 > 0)
+      {
+	s = re_malloc (char, len);
+
+	if (__glibc_unlikely (s == NULL))
+	  return -2;
+	memcpy (s, string1, length1);
+	memcpy (s + length1, string2, length2);
+	str = s;
+      }
+    else
+      str = string2;
+  else
+    str = string1;
+
+  rval = re_search_stub (bufp, str, len, start, range, stop, regs,
+			 ret_len);
+  re_free (s);
+  return rval;
+}
+
+/* The parameters have the same meaning as those of re_search.
+   Additional parameters:
+   If RET_LEN is true the length of the match is returned (re_match style);
+   otherwise the position of the match is returned.  */
+
+static regoff_t
+re_search_stub (struct re_pattern_buffer *bufp, const char *string, Idx length,
+		Idx start, regoff_t range, Idx stop, struct re_registers *regs,
+		bool ret_len)
+{
+  reg_errcode_t result;
+  regmatch_t *pmatch;
+  Idx nregs;
+  regoff_t rval;
+  int eflags = 0;
+  re_dfa_t *dfa = bufp->buffer;
+  Idx last_start = start + range;
+
+  /* Check for out-of-range.  */
+  if (__glibc_unlikely (start < 0 || start > length))
+    return -1;
+  if (__glibc_unlikely (length < last_start
+			|| (0 <= range && last_start < start)))
+    last_start = length;
+  else if (__glibc_unlikely (last_start < 0
+			     || (range < 0 && start <= last_start)))
+    last_start = 0;
+
+  lock_lock (dfa->lock);
+
+  eflags |= (bufp->not_bol) ? REG_NOTBOL : 0;
+  eflags |= (bufp->not_eol) ? REG_NOTEOL : 0;
+
+  /* Compile fastmap if we haven't yet.  */
+  if (start < last_start && bufp->fastmap != NULL && !bufp->fastmap_accurate)
+    re_compile_fastmap (bufp);
+
+  if (__glibc_unlikely (bufp->no_sub))
+    regs = NULL;
+
+  /* We need at least 1 register.  */
+  if (regs == NULL)
+    nregs = 1;
+  else if (__glibc_unlikely (bufp->regs_allocated == REGS_FIXED
+			     && regs->num_regs <= bufp->re_nsub))
+    {
+      nregs = regs->num_regs;
+      if (__glibc_unlikely (nregs < 1))
+	{
+	  /* Nothing can be copied to regs.  */
+	  regs = NULL;
+	  nregs = 1;
+	}
+    }
+  else
+    nregs = bufp->re_nsub + 1;
+  pmatch = re_malloc (regmatch_t, nregs);
+  if (__glibc_unlikely (pmatch == NULL))
+    {
+      rval = -2;
+      goto out;
+    }
+
+  result = re_search_internal (bufp, string, length, start, last_start, stop,
+			       nregs, pmatch, eflags);
+
+  rval = 0;
+
+  /* I hope we needn't fill their regs with -1's when no match was found.  */
+  if (result != REG_NOERROR)
+    rval = result == REG_NOMATCH ? -1 : -2;
+  else if (regs != NULL)
+    {
+      /* If caller wants register contents data back, copy them.  */
+      bufp->regs_allocated = re_copy_regs (regs, pmatch, nregs,
+					   bufp->regs_allocated);
+      if (__glibc_unlikely (bufp->regs_allocated == REGS_UNALLOCATED))
+	rval = -2;
+    }
+
+  if (__glibc_likely (rval == 0))
+    {
+      if (ret_len)
+	rval = pmatch[0].rm_eo - start;
+      else
+	rval = pmatch[0].rm_so;
+    }
+  re_free (pmatch);
+ out:
+  lock_unlock (dfa->lock);
+  return rval;
+}
+
+static unsigned
+re_copy_regs (struct re_registers *regs, regmatch_t *pmatch, Idx nregs,
+	      int regs_allocated)
+{
+  int rval = REGS_REALLOCATE;
+  Idx i;
+  Idx need_regs = nregs + 1;
+  /* We need one extra element beyond 'num_regs' for the '-1' marker GNU code
+     uses.  */
+
+  /* Have the register data arrays been allocated?  */
+  if (regs_allocated == REGS_UNALLOCATED)
+    { /* No.  So allocate them with malloc.  */
+      regs->start = re_malloc (regoff_t, need_regs);
+      if (__glibc_unlikely (regs->start == NULL))
+	return REGS_UNALLOCATED;
+      regs->end = re_malloc (regoff_t, need_regs);
+      if (__glibc_unlikely (regs->end == NULL))
+	{
+	  re_free (regs->start);
+	  return REGS_UNALLOCATED;
+	}
+      regs->num_regs = need_regs;
+    }
+  else if (regs_allocated == REGS_REALLOCATE)
+    { /* Yes.  If we need more elements than were already
+	 allocated, reallocate them.  If we need fewer, just
+	 leave it alone.  */
+      if (__glibc_unlikely (need_regs > regs->num_regs))
+	{
+	  regoff_t *new_start = re_realloc (regs->start, regoff_t, need_regs);
+	  regoff_t *new_end;
+	  if (__glibc_unlikely (new_start == NULL))
+	    return REGS_UNALLOCATED;
+	  new_end = re_realloc (regs->end, regoff_t, need_regs);
+	  if (__glibc_unlikely (new_end == NULL))
+	    {
+	      re_free (new_start);
+	      return REGS_UNALLOCATED;
+	    }
+	  regs->start = new_start;
+	  regs->end = new_end;
+	  regs->num_regs = need_regs;
+	}
+    }
+  else
+    /* This function may not be called with REGS_FIXED and nregs too
+       big.  */
+    rval = REGS_FIXED;
+
+  /* Copy the regs.  */
+  for (i = 0; i < nregs; ++i)
+    {
+      regs->start[i] = pmatch[i].rm_so;
+      regs->end[i] = pmatch[i].rm_eo;
+    }
+  for ( ; i < regs->num_regs; ++i)
+    regs->start[i] = regs->end[i] = -1;
+
+  return rval;
+}
+
+/* Set REGS to hold NUM_REGS registers, storing them in STARTS and
+   ENDS.  Subsequent matches using PATTERN_BUFFER and REGS will use
+   this memory for recording register information.  STARTS and ENDS
+   must be allocated using the malloc library routine, and must each
+   be at least NUM_REGS * sizeof (regoff_t) bytes long.
+
+   If NUM_REGS == 0, then subsequent matches should allocate their own
+   register data.
+
+   Unless this function is called, the first search or match using
+   PATTERN_BUFFER will allocate its own register data, without
+   freeing the old data.  */
+
+void
+re_set_registers (struct re_pattern_buffer *bufp, struct re_registers *regs,
+		  __re_size_t num_regs, regoff_t *starts, regoff_t *ends)
+{
+  if (num_regs)
+    {
+      bufp->regs_allocated = REGS_REALLOCATE;
+      regs->num_regs = num_regs;
+      regs->start = starts;
+      regs->end = ends;
+    }
+  else
+    {
+      bufp->regs_allocated = REGS_UNALLOCATED;
+      regs->num_regs = 0;
+      regs->start = regs->end = NULL;
+    }
+}
+
+/* Functions for contexts.  */
+
+/* Return the context of the byte at IDX of STRING, whose length is
+   LENGTH; -1 and LENGTH are the ends of the string.  */
+
+static inline unsigned int
+re_string_context_at (const re_dfa_t *dfa, const unsigned char *string,
+		      Idx length, Idx idx, int eflags)
+{
+  if (idx < 0)
+    return dfa->class_context[dfa->nclasses + !!(eflags & REG_NOTBOL)];
+  if (idx == length)
+    return dfa->class_context[dfa->nclasses + !!(eflags & REG_NOTEOL)];
+  return dfa->class_context[dfa->byteclass[string[idx]]];
+}
+
+/* Return the class standing for the byte at IDX, as re_string_context_at
+   does.  */
+
+static inline int
+re_string_class_at (const re_dfa_t *dfa, const unsigned char *string,
+		    Idx length, Idx idx, int eflags)
+{
+  if (idx < 0)
+    return dfa->nclasses + !!(eflags & REG_NOTBOL);
+  if (idx == length)
+    return dfa->nclasses + !!(eflags & REG_NOTEOL);
+  return dfa->byteclass[string[idx]];
+}
+
+/* Return true if the constraint TYPE holds between a byte of context
+   PREV and one of context NEXT.  */
+
+static inline bool
+check_anchor (re_context_type type, unsigned int prev, unsigned int next)
+{
+  switch (type)
+    {
+    case WORD_FIRST:
+      return !(prev & CONTEXT_WORD) && (next & CONTEXT_WORD);
+    case WORD_LAST:
+      return (prev & CONTEXT_WORD) && !(next & CONTEXT_WORD);
+    case WORD_DELIM:
+      return !(prev & CONTEXT_WORD) != !(next & CONTEXT_WORD);
+    case NOT_WORD_DELIM:
+      return !(prev & CONTEXT_WORD) == !(next & CONTEXT_WORD);
+    case LINE_FIRST:
+      return prev & CONTEXT_NEWLINE;
+    case LINE_LAST:
+      return next & CONTEXT_NEWLINE;
+    case BUF_FIRST:
+      return prev & CONTEXT_BUF;
+    case BUF_LAST:
+      return next & CONTEXT_BUF;
+    }
+  return false;
+}
+
+/* Return where the first occurrence of the string every match contains
+   starts in STRING from FROM on, ending by STOP; or -1 if there is
+   none.  */
+
+static Idx
+find_must (const re_dfa_t *dfa, const unsigned char *string, Idx from,
+	   Idx stop)
+{
+  Idx len = dfa->must_len;
+  Idx pivot = dfa->must_pivot;
+  Idx end = stop - len + pivot + 1;
+  Idx p = from + pivot;
+
+  while (p < end)
+    {
+      Idx q, i;
+      p += simd_byteset_scan (&dfa->must_set, string + p, end - p);
+      if (p == end)
+	break;
+      q = p - pivot;
+      for (i = 0; i < len && dfa->trans[string[q + i]] == dfa->must[i]; i++)
+	;
+      if (i == len)
+	return q;
+      p++;
+    }
+  return -1;
+}
+
+/* Functions for the DFA.  */
+
+static int
+compare_nodes (const void *a, const void *b)
+{
+  Idx x = *(const Idx *) a, y = *(const Idx *) b;
+  return (x > y) - (x < y);
+}
+
+static void
+sort_nodes (Idx *nodes, Idx n)
+{
+  Idx i, j;
+  /* Groups are small but for sets of many patterns.  */
+  if (n > 32)
+    {
+      qsort (nodes, n, sizeof *nodes, compare_nodes);
+      return;
+    }
+  for (i = 1; i < n; i++)
+    {
+      Idx node = nodes[i];
+      for (j = i; j > 0 && nodes[j - 1] > node; j--)
+	nodes[j] = nodes[j - 1];
+      nodes[j] = node;
+    }
+}
+
+/* Return the state of PROG that STATE goes to on a byte of class CLS,
+   or at an end of the string, and remember it in STATE.  Return NULL if
+   there is no memory.
+
+   The threads of each group are followed through the instructions
+   that consume nothing, and those that can then consume the byte make
+   up the group in the new state.  A thread reaching an instruction
+   that a group of an earlier start has reached is dropped: whatever it
+   could go on to match, the earlier one matches too.  Once a group
+   reaches INST_MATCH, the groups after it can no longer make the
+   leftmost match and are dropped, and no thread is started any more.
+
+   The DFA of a set of patterns wants every match instead: its states
+   have one group, started threads joining it, and list at their end the
+   INST_MATCH reached, which are not followed any further.  */
+
+static re_dfastate_t *
+dfa_transit (re_dfa_t *dfa, re_prog_t *prog, re_dfastate_t *state, int cls)
+{
+  const re_inst_t *insts = prog->insts;
+  unsigned int prev = state->flags & CONTEXT_ALL;
+  unsigned int next = dfa->class_context[cls];
+  int c = cls < dfa->nclasses ? dfa->class_byte[cls] : -1;
+  unsigned int flags = c < 0 ? 0 : next;
+  bool start = (state->flags & STATE_START) && c >= 0;
+  size_t nflushes = prog->nflushes;
+  Idx *stack = prog->stack;
+  Idx *work = prog->work;
+  Idx nwork = 0;
+  Idx i = 0;
+  bool all = prog->all_matches;
+  re_dfastate_t *result;
+
+  prog->nvisited = 0;
+  prog->nnext = 0;
+  while (i < state->nnodes)
+    {
+      Idx group = nwork;
+      bool matched = false;
+      for (; i < state->nnodes && state->nodes[i] != NODE_MARK; i++)
+	{
+	  Idx sp = 0;
+	  if (all && insts[state->nodes[i]].opcode == INST_MATCH)
+	    continue;
+	  stack[sp++] = state->nodes[i];
+	  while (sp > 0)
+	    {
+	      Idx pc = stack[--sp];
+	      const re_inst_t *inst = &insts[pc];
+	      if (!re_prog_visit (prog, pc))
+		continue;
+	      switch (inst->opcode)
+		{
+		case INST_CHARSET:
+		  if (c >= 0 && bitset_contain (dfa->sbcsets[inst->arg], c)
+		      && re_prog_add_next (prog, pc + 1))
+		    work[nwork++] = pc + 1;
+		  break;
+		case INST_ALT:
+		  stack[sp++] = inst->y;
+		  stack[sp++] = inst->x;
+		  break;
+		case INST_JMP:
+		  stack[sp++] = inst->x;
+		  break;
+		case INST_ANCHOR:
+		  if (check_anchor (inst->arg, prev, next))
+		    stack[sp++] = pc + 1;
+		  break;
+		case INST_SAVE:
+		  stack[sp++] = pc + 1;
+		  break;
+		case INST_BACKREF:
+		  /* Let the backreference match anything at all.  */
+		  if (c >= 0 && re_prog_add_next (prog, pc))
+		    work[nwork++] = pc;
+		  stack[sp++] = pc + 1;
+		  break;
+		case INST_MATCH:
+		  matched = true;
+		  if (all && re_prog_add_next (prog, pc))
+		    work[nwork++] = pc;
+		  break;
+		}
+	    }
+	}
+      i++;
+
+      if (nwork > group)
+	{
+	  sort_nodes (work + group, nwork - group);
+	  work[nwork++] = NODE_MARK;
+	}
+      if (matched)
+	{
+	  flags |= STATE_MATCH;
+	  if (!all)
+	    {
+	      start = false;
+	      break;
+	    }
+	}
+    }
+  if (nwork > 0)
+    nwork--;
+
+  if (start)
+    {
+      if (nwork == 0)
+	flags |= STATE_INITIAL;
+      else if (!all)
+	work[nwork++] = NODE_MARK;
+      if (all)
+	{
+	  /* The entry is the least instruction.  */
+	  memmove (work + 1, work, nwork * sizeof *work);
+	  work[0] = 0;
+	  nwork++;
+	}
+      else
+	work[nwork++] = 0;
+      flags |= STATE_START;
+    }
+  else if (nwork == 0)
+    flags |= STATE_DEAD;
+
+  result = re_acquire_state (dfa, prog, work, nwork, flags);
+  /* If the cache was flushed, STATE is gone.  */
+  if (__glibc_likely (result != NULL && prog->nflushes == nflushes))
+    state->trans[cls] = result;
+  return result;
+}
+
+/* Return the state of PROG to start at a position whose previous byte
+   has context CTX, starting a thread at every later position too if
+   UNANCHORED.  */
+
+static re_dfastate_t *
+dfa_start_state (re_dfa_t *dfa, re_prog_t *prog, bool unanchored,
+		 unsigned int ctx)
+{
+  re_dfastate_t *state = prog->init[unanchored][ctx];
+  if (state == NULL)
+    {
+      Idx entry = 0;
+      state = re_acquire_state (dfa, prog, &entry, 1,
+				ctx | (unanchored
+				       ? STATE_START | STATE_INITIAL : 0));
+      prog->init[unanchored][ctx] = state;
+    }
+  return state;
+}
+
+/* Return STATE without starting threads any more.  */
+
+static re_dfastate_t *
+dfa_stop_starting (re_dfa_t *dfa, re_prog_t *prog, re_dfastate_t *state)
+{
+  return re_acquire_state (dfa, prog, state->nodes, state->nnodes,
+			   state->flags & ~(STATE_START | STATE_INITIAL));
+}
+
+/* Tell whether PROG, having run NBYTES since its cache was last flushed,
+   flushed it again for making too few of its NSTATES states worth it.
+   Then a DFA is no faster than an NFA.  */
+
+static bool
+dfa_thrashing (re_prog_t *prog, size_t nflushes, Idx nbytes, size_t nstates)
+{
+  return prog->nflushes != nflushes && (size_t) nbytes < 10 * nstates;
+}
+
+/* Run the forward DFA over STRING, whose length is LENGTH, from START,
+   starting a thread at each position up to LAST_START, and matching up
+   to STOP.  Return where the leftmost-longest match ends, or if FIRST
+   where some match ends; or SCAN_NOMATCH, SCAN_ESPACE or SCAN_THRASH.  */
+
+static Idx
+dfa_scan_forward (re_dfa_t *dfa, const unsigned char *string, Idx length,
+		  Idx start, Idx last_start, Idx stop, int eflags, bool first)
+{
+  re_prog_t *prog = &dfa->fwd;
+  const unsigned char *byteclass = dfa->byteclass;
+  bool skip = !dfa->can_be_null && dfa->first_scan.count < SBC_MAX;
+  Idx match_last = SCAN_NOMATCH;
+  Idx must_at = -1, must_from = -1;
+  Idx flushed_at = start;
+  Idx p = start;
+  re_dfastate_t *state;
+
+  if (last_start > stop)
+    last_start = stop;
+  state = dfa_start_state (dfa, prog, start < last_start,
+			   re_string_context_at (dfa, string, length,
+						 start - 1, eflags));
+  if (__glibc_unlikely (state == NULL))
+    return SCAN_ESPACE;
+
+  for (;;)
+    {
+      re_dfastate_t *next;
+      size_t nflushes, nstates;
+      Idx lim;
+      int cls;
+
+      if (state->flags & STATE_START)
+	{
+	  if (p == last_start)
+	    {
+	      state = dfa_stop_starting (dfa, prog, state);
+	      if (__glibc_unlikely (state == NULL))
+		return SCAN_ESPACE;
+	    }
+	  else if (state->flags & STATE_INITIAL)
+	    {
+	      /* Nothing but the thread started here is alive.  A match
+		 holds the required string, starting with it or in the
+		 same line if it says so, and starts with a byte of the
+		 first set.  */
+	      Idx q = p;
+	      if (dfa->must_len > 0)
+		{
+		  if (must_at < p)
+		    {
+		      must_at = find_must (dfa, string, p, stop);
+		      if (must_at < 0)
+			break;
+		      must_from = p;
+		      if (dfa->must_prefix)
+			must_from = must_at;
+		      else if (dfa->must_lines)
+			{
+			  const unsigned char *nl
+			    = memrchr (string + p, '\n', must_at - p);
+			  if (nl != NULL)
+			    must_from = nl + 1 - string;
+			}
+		    }
+		  if (q < must_from)
+		    q = must_from;
+		  if (q > last_start)
+		    break;
+		}
+	      if (skip && q < last_start)
+		q += simd_byteset_scan (&dfa->first_scan, string + q,
+					last_start - q);
+	      if (q != p)
+		{
+		  p = q;
+		  state = dfa_start_state (dfa, prog, true,
+					   dfa->class_context[byteclass[string[p - 1]]]);
+		  if (__glibc_unlikely (state == NULL))
+		    return SCAN_ESPACE;
+		  continue;
+		}
+	    }
+	}
+
+      /* The fast path: follow the transitions already built.  */
+      lim = (state->flags & STATE_START) ? last_start : stop;
+      while (p < lim
+	     && (next = state->trans[byteclass[string[p]]]) != NULL
+	     && !(next->flags & STATE_SPECIAL))
+	{
+	  state = next;
+	  p++;
+	}
+      if (p == last_start && (state->flags & STATE_START))
+	continue;
+
+      cls = (p < stop ? byteclass[string[p]]
+	     : re_string_class_at (dfa, string, length, p, eflags));
+      next = state->trans[cls];
+      if (next == NULL)
+	{
+	  nflushes = prog->nflushes;
+	  nstates = prog->nstates;
+	  next = dfa_transit (dfa, prog, state, cls);
+	  if (__glibc_unlikely (next == NULL))
+	    return SCAN_ESPACE;
+	  if (prog->nflushes != nflushes)
+	    {
+	      if (dfa_thrashing (prog, nflushes, p - flushed_at, nstates))
+		return SCAN_THRASH;
+	      flushed_at = p;
+	    }
+	}
+      state = next;
+      if (state->flags & STATE_MATCH)
+	{
+	  match_last = p;
+	  if (first)
+	    break;
+	}
+      if (p == stop || (state->flags & STATE_DEAD))
+	break;
+      p++;
+    }
+  return match_last;
+}
+
+/* Run the reverse DFA over STRING, whose length is LENGTH, from END
+   back to START.  Return where the longest match of the pattern ending
+   at END starts; or SCAN_NOMATCH, SCAN_ESPACE or SCAN_THRASH.  */
+
+static Idx
+dfa_scan_backward (re_dfa_t *dfa, const unsigned char *string, Idx length,
+		   Idx start, Idx end, int eflags)
+{
+  re_prog_t *prog = &dfa->rev;
+  Idx match_first = SCAN_NOMATCH;
+  Idx flushed_at = end;
+  Idx p = end;
+  re_dfastate_t *state;
+
+  state = dfa_start_state (dfa, prog, false,
+			   re_string_context_at (dfa, string, length, end,
+						 eflags));
+  if (__glibc_unlikely (state == NULL))
+    return SCAN_ESPACE;
+
+  for (;;)
+    {
+      re_dfastate_t *next;
+      int cls = (p > start ? dfa->byteclass[string[p - 1]]
+		 : re_string_class_at (dfa, string, length, p - 1, eflags));
+      next = state->trans[cls];
+      if (next == NULL)
+	{
+	  size_t nflushes = prog->nflushes;
+	  size_t nstates = prog->nstates;
+	  next = dfa_transit (dfa, prog, state, cls);
+	  if (__glibc_unlikely (next == NULL))
+	    return SCAN_ESPACE;
+	  if (prog->nflushes != nflushes)
+	    {
+	      if (dfa_thrashing (prog, nflushes, flushed_at - p, nstates))
+		return SCAN_THRASH;
+	      flushed_at = p;
+	    }
+	}
+      state = next;
+      if (state->flags & STATE_MATCH)
+	match_first = p;
+      if (p == start || (state->flags & STATE_DEAD))
+	break;
+      p--;
+    }
+  return match_first;
+}
+
+/* Run the DFA of a set of patterns over STRING, whose length is
+   LENGTH, starting a thread at every position, and set MATCHED[I] for
+   each of its NPATTERNS patterns I that matches somewhere.  Return how
+   many do, or SCAN_ESPACE.  */
+
+static Idx
+dfa_scan_set (re_dfa_t *dfa, const unsigned char *string, Idx length,
+	      int eflags, char *matched, Idx npatterns)
+{
+  re_prog_t *prog = &dfa->fwd;
+  const unsigned char *byteclass = dfa->byteclass;
+  bool skip = !dfa->can_be_null && dfa->first_scan.count < SBC_MAX;
+  Idx nmatched = 0;
+  Idx p = 0;
+  re_dfastate_t *state;
+
+  state = dfa_start_state (dfa, prog, true,
+			   re_string_context_at (dfa, string, length, -1,
+						 eflags));
+  if (__glibc_unlikely (state == NULL))
+    return SCAN_ESPACE;
+
+  for (;;)
+    {
+      re_dfastate_t *next;
+      int cls;
+
+      if ((state->flags & STATE_INITIAL) && skip && p < length)
+	{
+	  Idx q = p + simd_byteset_scan (&dfa->first_scan, string + p,
+					 length - p);
+	  if (q != p)
+	    {
+	      p = q;
+	      state = dfa_start_state (dfa, prog, true,
+				       dfa->class_context[byteclass[string[p - 1]]]);
+	      if (__glibc_unlikely (state == NULL))
+		return SCAN_ESPACE;
+	    }
+	}
+
+      while (p < length
+	     && (next = state->trans[byteclass[string[p]]]) != NULL
+	     && !(next->flags & STATE_SPECIAL))
+	{
+	  state = next;
+	  p++;
+	}
+
+      /* The cache may thrash here, but with no faster way to find every
+	 match, the DFA carries on.  */
+      cls = (p < length ? byteclass[string[p]]
+	     : re_string_class_at (dfa, string, length, p, eflags));
+      next = state->trans[cls];
+      if (next == NULL)
+	{
+	  next = dfa_transit (dfa, prog, state, cls);
+	  if (__glibc_unlikely (next == NULL))
+	    return SCAN_ESPACE;
+	}
+      state = next;
+      if (state->flags & STATE_MATCH)
+	{
+	  Idx i;
+	  for (i = state->nnodes - 1;
+	       i >= 0 && prog->insts[state->nodes[i]].opcode == INST_MATCH; i--)
+	    {
+	      Idx id = prog->insts[state->nodes[i]].arg;
+	      if (!matched[id])
+		{
+		  matched[id] = 1;
+		  if (++nmatched == npatterns)
+		    return nmatched;
+		}
+	    }
+	}
+      if (p == length)
+	break;
+      p++;
+    }
+  return nmatched;
+}
+
+/* Functions for the NFA.  */
+
+/* A Pike VM: the threads of the NFA are run in lockstep over the
+   string, each with the registers it has recorded.  Threads are kept in
+   order of priority, which puts those of earlier starts first.  */
+
+typedef struct
+{
+  Idx *sparse;
+  Idx *dense;
+  Idx n;
+  regoff_t *caps;               /* NCAP registers for each thread */
+} re_threadlist_t;
+
+typedef struct
+{
+  const re_dfa_t *dfa;
+  const re_prog_t *prog;
+  const unsigned char *string;
+  Idx length;
+  int eflags;
+  Idx ncap;
+  re_threadlist_t list[2];
+  Idx *stack;                   /* instructions, or ~register to restore */
+  regoff_t *saved;
+} re_pike_t;
+
+/* Add to LIST the thread at PC with registers CAPS, at position IDX,
+   following the instructions that consume nothing.  CAPS is restored
+   before returning.  */
+
+static void
+pike_add_thread (re_pike_t *pike, re_threadlist_t *list, Idx pc,
+		 regoff_t *caps, Idx idx)
+{
+  const re_inst_t *insts = pike->prog->insts;
+  Idx *stack = pike->stack;
+  regoff_t *saved = pike->saved;
+  Idx sp = 0;
+  unsigned int prev = re_string_context_at (pike->dfa, pike->string,
+					    pike->length, idx - 1,
+					    pike->eflags);
+  unsigned int next = re_string_context_at (pike->dfa, pike->string,
+					    pike->length, idx,
+					    pike->eflags);
+
+  stack[sp++] = pc;
+  while (sp > 0)
+    {
+      const re_inst_t *inst;
+      Idx i;
+      pc = stack[--sp];
+      if (pc < 0)
+	{
+	  /* Restore the register a SAVE set.  */
+	  caps[~pc] = saved[sp];
+	  continue;
+	}
+      i = list->sparse[pc];
+      if ((size_t) i < (size_t) list->n && list->dense[i] == pc)
+	continue;
+      list->sparse[pc] = list->n;
+      list->dense[list->n++] = pc;
+      inst = &insts[pc];
+      switch (inst->opcode)
+	{
+	case INST_CHARSET:
+	case INST_MATCH:
+	case INST_BACKREF:
+	  memcpy (list->caps + list->sparse[pc] * pike->ncap, caps,
+		  pike->ncap * sizeof (regoff_t));
+	  break;
+	case INST_ALT:
+	  stack[sp++] = inst->y;
+	  stack[sp++] = inst->x;
+	  break;
+	case INST_JMP:
+	  stack[sp++] = inst->x;
+	  break;
+	case INST_ANCHOR:
+	  if (check_anchor (inst->arg, prev, next))
+	    stack[sp++] = pc + 1;
+	  break;
+	case INST_SAVE:
+	  if (inst->arg < pike->ncap)
+	    {
+	      saved[sp] = caps[inst->arg];
+	      stack[sp++] = ~inst->arg;
+	      caps[inst->arg] = idx;
+	    }
+	  stack[sp++] = pc + 1;
+	  break;
+	}
+    }
+}
+
+/* Find with the Pike VM the leftmost-longest match starting between
+   START and LAST_START, and not going past STOP, and put its registers
+   in CAPS.  If MATCH_LAST is not -1, the match must end there, and
+   otherwise if DFA wants the earliest match, the first to end wins.
+   Return REG_NOMATCH if there is none.  The program must have no
+   backreferences.  */
+
+static reg_errcode_t
+pike_search (const re_dfa_t *dfa, const unsigned char *string, Idx length,
+	     Idx start, Idx last_start, Idx stop, Idx match_last,
+	     int eflags, regoff_t *caps, Idx ncap)
+{
+  const re_prog_t *prog = &dfa->fwd;
+  Idx n = prog->ninsts;
+  re_pike_t pike;
+  re_threadlist_t *clist, *nlist;
+  regoff_t *work;
+  regoff_t cut;
+  bool found = false;
+  Idx p, i;
+
+  pike.dfa = dfa;
+  pike.prog = prog;
+  pike.string = string;
+  pike.length = length;
+  pike.eflags = eflags;
+  pike.ncap = ncap;
+  pike.stack = re_malloc (Idx, 7 * (size_t) n + 2);
+  pike.saved = re_malloc (regoff_t, 3 * (size_t) n + 2
+			  + (2 * (size_t) n + 1) * ncap);
+  if (__glibc_unlikely (pike.stack == NULL || pike.saved == NULL))
+    {
+      re_free (pike.stack);
+      re_free (pike.saved);
+      return REG_ESPACE;
+    }
+  for (i = 0; i < 2; i++)
+    {
+      pike.list[i].sparse = pike.stack + 3 * n + 2 + 2 * i * n;
+      pike.list[i].dense = pike.list[i].sparse + n;
+      pike.list[i].n = 0;
+      pike.list[i].caps = pike.saved + 3 * n + 2 + i * n * ncap;
+    }
+  work = pike.saved + 3 * n + 2 + 2 * n * ncap;
+  clist = &pike.list[0];
+  nlist = &pike.list[1];
+
+  for (p = start; ; p++)
+    {
+      if (!found && p <= last_start)
+	{
+	  for (i = 0; i < ncap; i++)
+	    work[i] = -1;
+	  pike_add_thread (&pike, clist, 0, work, p);
+	}
+      if (clist->n == 0)
+	break;
+
+      nlist->n = 0;
+      cut = -1;
+      for (i = 0; i < clist->n; i++)
+	{
+	  Idx pc = clist->dense[i];
+	  const re_inst_t *inst = &prog->insts[pc];
+	  regoff_t *tcaps = clist->caps + i * ncap;
+	  if (inst->opcode != INST_CHARSET && inst->opcode != INST_MATCH)
+	    continue;
+	  /* Once a match is found, threads that started later cannot make
+	     the leftmost one.  */
+	  if (cut != -1 && tcaps[0] != cut)
+	    break;
+	  if (inst->opcode == INST_MATCH)
+	    {
+	      if (match_last != -1
+		  ? p == match_last
+		  : (!found || tcaps[0] < caps[0]
+		     || (tcaps[0] == caps[0] && p > caps[1])))
+		{
+		  memcpy (caps, tcaps, ncap * sizeof (regoff_t));
+		  found = true;
+		}
+	      if (match_last == -1)
+		cut = tcaps[0];
+	      else if (p == match_last)
+		break;
+	      continue;
+	    }
+	  if (p < stop && bitset_contain (dfa->sbcsets[inst->arg], string[p]))
+	    pike_add_thread (&pike, nlist, pc + 1, tcaps, p + 1);
+	}
+      if (p == stop || (match_last != -1 && p >= match_last)
+	  || (found && dfa->earliest))
+	break;
+      {
+	re_threadlist_t *tmp = clist;
+	clist = nlist;
+	nlist = tmp;
+      }
+    }
+
+  re_free (pike.stack);
+  re_free (pike.saved);
+  return found ? REG_NOERROR : REG_NOMATCH;
+}
+
+/* Functions for backreferences.  */
+
+/* The branch points a backtracking search has gone through, each an
+   instruction, a position, and the registers that backreferences read.
+   Going through one again can only match what it did the first time,
+   and with less priority, so it need not be.  */
+
+typedef struct
+{
+  Idx keyregs[18];
+  Idx keylen;
+  regoff_t *slots;              /* KEYLEN each, free if the first is -1 */
+  size_t mask;
+  size_t n;
+} re_memo_t;
+
+/* Branch points beyond this many are not remembered.  */
+#ifndef RE_MEMO_MAX
+# define RE_MEMO_MAX (1 << 20)
+#endif
+
+static reg_errcode_t
+memo_init (re_memo_t *memo, const re_prog_t *prog)
+{
+  unsigned int used = 0;
+  Idx i;
+
+  for (i = 0; i < prog->ninsts; i++)
+    if (prog->insts[i].opcode == INST_BACKREF)
+      used |= 1u << prog->insts[i].arg;
+  memo->keylen = 2;
+  for (i = 0; i < 9; i++)
+    if (used & (1u << i))
+      {
+	memo->keyregs[memo->keylen - 2] = 2 * i + 2;
+	memo->keyregs[memo->keylen - 1] = 2 * i + 3;
+	memo->keylen += 2;
+      }
+  memo->mask = 255;
+  memo->n = 0;
+  memo->slots = re_malloc (regoff_t, (memo->mask + 1) * memo->keylen);
+  if (__glibc_unlikely (memo->slots == NULL))
+    return REG_ESPACE;
+  memset (memo->slots, -1, (memo->mask + 1) * memo->keylen * sizeof (regoff_t));
+  return REG_NOERROR;
+}
+
+static regoff_t *
+memo_lookup (regoff_t *slots, size_t mask, Idx keylen, const regoff_t *key)
+{
+  re_hashval_t hash = 0;
+  size_t i;
+  Idx k;
+
+  for (k = 0; k < keylen; k++)
+    hash = (hash ^ (re_hashval_t) key[k]) * 0x01000193u;
+  for (i = hash & mask; ; i = (i + 1) & mask)
+    {
+      regoff_t *slot = slots + i * keylen;
+      if (slot[0] == -1
+	  || memcmp (slot, key, keylen * sizeof (regoff_t)) == 0)
+	return slot;
+    }
+}
+
+/* Return true if the branch point at PC and P with REGS was gone
+   through already, and remember it otherwise.  */
+
+static bool
+memo_seen (re_memo_t *memo, Idx pc, Idx p, const regoff_t *regs)
+{
+  regoff_t key[20];
+  regoff_t *slot;
+  Idx k;
+
+  key[0] = pc;
+  key[1] = p;
+  for (k = 2; k < memo->keylen; k++)
+    key[k] = regs[memo->keyregs[k - 2]];
+  slot = memo_lookup (memo->slots, memo->mask, memo->keylen, key);
+  if (slot[0] != -1)
+    return true;
+  if (memo->n >= RE_MEMO_MAX)
+    return false;
+  memcpy (slot, key, memo->keylen * sizeof (regoff_t));
+  if (++memo->n * 2 > memo->mask)
+    {
+      size_t mask = memo->mask * 2 + 1;
+      regoff_t *slots = re_malloc (regoff_t, (mask + 1) * memo->keylen);
+      size_t i;
+      /* Forgetting is slower, but no less right.  */
+      if (slots == NULL)
+	{
+	  memo->n = RE_MEMO_MAX;
+	  return false;
+	}
+      memset (slots, -1, (mask + 1) * memo->keylen * sizeof (regoff_t));
+      for (i = 0; i <= memo->mask; i++)
+	{
+	  regoff_t *old = memo->slots + i * memo->keylen;
+	  if (old[0] != -1)
+	    memcpy (memo_lookup (slots, mask, memo->keylen, old), old,
+		    memo->keylen * sizeof (regoff_t));
+	}
+      re_free (memo->slots);
+      memo->slots = slots;
+      memo->mask = mask;
+    }
+  return false;
+}
+
+/* Find by backtracking the longest match starting at START and not
+   going past STOP, or the shortest if DFA wants the earliest match, and
+   put its registers in CAPS; of the ways of matching that far, the
+   first in order of priority sets them.  Return REG_NOMATCH if there is
+   none.  MEMO holds the branch points earlier searches went through
+   without matching a better one.  */
+
+static reg_errcode_t
+backtrack_match (const re_dfa_t *dfa, const unsigned char *string,
+		 Idx length, Idx start, Idx stop, int eflags,
+		 regoff_t *caps, Idx ncap, re_memo_t *memo)
+{
+  /* The stack holds threads to try, and undo records: a register and
+     its old value, or an INST_ALT and the position it was last reached
+     at.  */
+  enum { BT_THREAD, BT_REG, BT_LOOP };
+  typedef struct { unsigned char kind; Idx a; regoff_t b; } bt_entry_t;
+  const re_prog_t *prog = &dfa->fwd;
+  const unsigned char *trans = dfa->trans;
+  bt_entry_t *stack;
+  Idx sp = 0, alloc = 64;
+  regoff_t *regs, *loop_at;
+  Idx match_last = -1;
+  Idx i;
+
+  stack = re_malloc (bt_entry_t, alloc);
+  regs = re_malloc (regoff_t, ncap + prog->ninsts);
+  if (__glibc_unlikely (stack == NULL || regs == NULL))
+    {
+      re_free (stack);
+      re_free (regs);
+      return REG_ESPACE;
+    }
+  loop_at = regs + ncap;
+  for (i = 0; i < ncap; i++)
+    regs[i] = -1;
+  for (i = 0; i < prog->ninsts; i++)
+    loop_at[i] = -1;
+
+  stack[sp].kind = BT_THREAD;
+  stack[sp].a = 0;
+  stack[sp++].b = start;
+  while (sp > 0)
+    {
+      bt_entry_t e = stack[--sp];
+      Idx pc = e.a;
+      Idx p = e.b;
+
+      if (e.kind == BT_REG)
+	{
+	  regs[e.a] = e.b;
+	  continue;
+	}
+      if (e.kind == BT_LOOP)
+	{
+	  loop_at[e.a] = e.b;
+	  continue;
+	}
+
+      for (;;)
+	{
+	  const re_inst_t *inst = &prog->insts[pc];
+
+	  /* Make room for the two records an instruction may push.  */
+	  if (sp + 2 > alloc)
+	    {
+	      /* Not re_realloc, after which GCC takes freeing the old stack
+		 on failure for a use after free.  */
+	      bt_entry_t *new_stack = re_malloc (bt_entry_t, alloc * 2);
+	      if (__glibc_unlikely (new_stack == NULL))
+		{
+		  re_free (stack);
+		  re_free (regs);
+		  return REG_ESPACE;
+		}
+	      memcpy (new_stack, stack, sp * sizeof (bt_entry_t));
+	      re_free (stack);
+	      stack = new_stack;
+	      alloc *= 2;
+	    }
+
+	  if (inst->opcode == INST_CHARSET)
+	    {
+	      if (p < stop && bitset_contain (dfa->sbcsets[inst->arg],
+					      string[p]))
+		{
+		  pc++;
+		  p++;
+		  continue;
+		}
+	    }
+	  else if (inst->opcode == INST_ALT)
+	    {
+	      /* Going round a loop without consuming anything would only
+		 come back here again.  */
+	      if (loop_at[pc] != p && !memo_seen (memo, pc, p, regs))
+		{
+		  stack[sp].kind = BT_LOOP;
+		  stack[sp].a = pc;
+		  stack[sp++].b = loop_at[pc];
+		  loop_at[pc] = p;
+		  stack[sp].kind = BT_THREAD;
+		  stack[sp].a = inst->y;
+		  stack[sp++].b = p;
+		  pc = inst->x;
+		  continue;
+		}
+	    }
+	  else if (inst->opcode == INST_JMP)
+	    {
+	      pc = inst->x;
+	      continue;
+	    }
+	  else if (inst->opcode == INST_SAVE)
+	    {
+	      if (inst->arg < ncap)
+		{
+		  stack[sp].kind = BT_REG;
+		  stack[sp].a = inst->arg;
+		  stack[sp++].b = regs[inst->arg];
+		  regs[inst->arg] = p;
+		}
+	      pc++;
+	      continue;
+	    }
+	  else if (inst->opcode == INST_ANCHOR)
+	    {
+	      if (check_anchor (inst->arg,
+				re_string_context_at (dfa, string, length,
+						      p - 1, eflags),
+				re_string_context_at (dfa, string, length,
+						      p, eflags)))
+		{
+		  pc++;
+		  continue;
+		}
+	    }
+	  else if (inst->opcode == INST_BACKREF)
+	    {
+	      regoff_t from = regs[2 * inst->arg + 2];
+	      regoff_t to = regs[2 * inst->arg + 3];
+	      if (from >= 0 && to >= from && to - from <= stop - p)
+		{
+		  Idx len = to - from, k;
+		  for (k = 0; k < len; k++)
+		    if (trans[string[from + k]] != trans[string[p + k]])
+		      break;
+		  if (k == len)
+		    {
+		      pc++;
+		      p += len;
+		      continue;
+		    }
+		}
+	    }
+	  else if (dfa->earliest ? match_last < 0 || p < match_last
+		   : p > match_last)
+	    {
+	      /* INST_MATCH, the first to get this far.  */
+	      match_last = p;
+	      memcpy (caps, regs, ncap * sizeof (regoff_t));
+	      if (dfa->earliest)
+		{
+		  /* Only a match that ends sooner can do better, and none
+		     can if this one is empty.  */
+		  stop = p;
+		  if (p == start)
+		    sp = 0;
+		}
+	      /* Nothing can get further.  */
+	      else if (p == stop)
+		sp = 0;
+	    }
+	  break;
+	}
+    }
+
+  re_free (stack);
+  re_free (regs);
+  return match_last >= 0 ? REG_NOERROR : REG_NOMATCH;
+}
+
+/* Functions for searching.  */
+
+/* Search STRING for the literals of DFA as search_no_backref does for
+   a pattern: from START up to LAST_START, or down to it, for the match
+   that starts first and then for the longest one there, ending by STOP.
+   Leave its bounds in CAPS if NCAP is not 0.  */
+
+static reg_errcode_t
+search_literals (const re_dfa_t *dfa, const unsigned char *string,
+		 Idx start, Idx last_start, Idx stop, regoff_t *caps,
+		 Idx ncap)
+{
+  const re_literals_t *lit = dfa->literals;
+  const Idx *trans = lit->trans;
+  const unsigned char *byteclass = lit->byteclass;
+  Idx depth = lit->nclasses, out = lit->nclasses + 1;
+  Idx first = -1, last = -1;
+  Idx state, p, end;
+  bool skip = !dfa->can_be_null && dfa->first_scan.count < SBC_MAX;
+  Idx gain = 0;
+
+  if (start >= last_start)
+    {
+      /* Try each start in turn, following the string down the trie for
+	 as long as it stays in it.  */
+      for (first = start; ; first--)
+	{
+	  for (state = 0, p = first; p < stop; p++)
+	    {
+	      state = trans[state + byteclass[string[p]]];
+	      if (trans[state + depth] != p + 1 - first)
+		break;
+	      if (trans[state + out] == p + 1 - first)
+		{
+		  last = p + 1;
+		  if (dfa->earliest)
+		    break;
+		}
+	    }
+	  if (last >= 0 || first == last_start)
+	    break;
+	}
+    }
+  else
+    {
+      /* Where a literal ends, the longest one that ends there starts
+	 first.  A match that starts by LAST_START ends by END, and once
+	 one is found, so does one that starts no later.  */
+      end = stop - lit->maxlen > last_start ? last_start + lit->maxlen : stop;
+      state = 0;
+      p = start;
+      while (p < end)
+	{
+	  if (state == 0 && skip)
+	    {
+	      Idx q = p + simd_byteset_scan (&dfa->first_scan, string + p,
+					     end - p);
+	      /* Where the bytes looked for are common, the automaton is
+		 quicker alone.  */
+	      gain += q - p - 8;
+	      if (gain > 256)
+		gain = 256;
+	      skip = gain > -256;
+	      p = q;
+	      if (p == end)
+		break;
+	    }
+
+	  /* Run until at the end of a literal, or back at the root if
+	     there is skipping to do from there.  */
+	  if (skip)
+	    do
+	      state = trans[state + byteclass[string[p++]]];
+	    while (state != 0 && trans[state + out] == 0 && p < end);
+	  else
+	    do
+	      state = trans[state + byteclass[string[p++]]];
+	    while (trans[state + out] == 0 && p < end);
+
+	  if (trans[state + out] != 0
+	      && p - trans[state + out] <= last_start
+	      && (first < 0 || p - trans[state + out] <= first))
+	    {
+	      first = p - trans[state + out];
+	      last = p;
+	      if (dfa->earliest)
+		break;
+	      if (end - lit->maxlen > first)
+		end = first + lit->maxlen;
+	    }
+	}
+    }
+
+  if (last < 0)
+    return REG_NOMATCH;
+  if (ncap != 0)
+    {
+      caps[0] = first;
+      caps[1] = last;
+    }
+  return REG_NOERROR;
+}
+
+/* Search for the leftmost-longest match of DFA in STRING starting at
+   START, or the earliest if DFA wants that, leaving CAPS set from the
+   NCAP registers of the match.  Then the bytes after STOP are context
+   only.  Search from START up to LAST_START, or down to it if it is
+   less than START; nothing is looked for if NCAP is 0.  */
+
+static reg_errcode_t
+search_no_backref (re_dfa_t *dfa, const unsigned char *string, Idx length,
+		   Idx start, Idx last_start, Idx stop, int eflags,
+		   regoff_t *caps, Idx ncap)
+{
+  Idx match_first, match_last;
+  Idx step = start <= last_start ? 1 : -1;
+  Idx from = start, to = last_start;
+
+  /* Searching backwards, the first position to match wins.  */
+  if (step < 0)
+    to = from;
+  for (;;)
+    {
+      match_last = dfa_scan_forward (dfa, string, length, from, to, stop,
+				     eflags, ncap == 0 || dfa->earliest);
+      if (match_last == SCAN_THRASH)
+	{
+	  reg_errcode_t err = pike_search (dfa, string, length, from, to,
+					   stop, -1, eflags, caps,
+					   ncap > 2 ? ncap : 2);
+	  if (err != REG_NOMATCH || step > 0 || from == last_start)
+	    return err;
+	  to = --from;
+	  continue;
+	}
+      if (match_last == SCAN_ESPACE)
+	return REG_ESPACE;
+      if (match_last != SCAN_NOMATCH)
+	break;
+      if (step > 0 || from == last_start)
+	return REG_NOMATCH;
+      to = --from;
+    }
+  if (ncap == 0)
+    return REG_NOERROR;
+
+  if (from == to)
+    match_first = from;
+  else
+    {
+      match_first = dfa_scan_backward (dfa, string, length, from,
+				       match_last, eflags);
+      if (match_first == SCAN_THRASH)
+	return pike_search (dfa, string, length, from, to, stop, -1,
+			    eflags, caps, ncap > 2 ? ncap : 2);
+      if (match_first == SCAN_ESPACE)
+	return REG_ESPACE;
+    }
+
+  if (ncap > 2)
+    return pike_search (dfa, string, length, match_first, match_first,
+			stop, match_last, eflags, caps, ncap);
+  caps[0] = match_first;
+  caps[1] = match_last;
+  return REG_NOERROR;
+}
+
+static reg_errcode_t
+search_backref (re_dfa_t *dfa, const unsigned char *string, Idx length,
+		Idx start, Idx last_start, Idx stop, int eflags,
+		regoff_t *caps, Idx ncap)
+{
+  Idx step = start <= last_start ? 1 : -1;
+  Idx match_first;
+  Idx match_last;
+  re_memo_t memo;
+  reg_errcode_t err;
+  bool found = false;
+
+  /* The DFA matches more than the pattern does, so a string it does
+     not match has no match.  */
+  match_last = dfa_scan_forward (dfa, string, length,
+				 start < last_start ? start : last_start,
+				 start < last_start ? last_start : start,
+				 stop, eflags, true);
+  if (match_last == SCAN_NOMATCH)
+    return REG_NOMATCH;
+  if (match_last == SCAN_ESPACE)
+    return REG_ESPACE;
+
+  /* What failed from one start fails from the next as well.  */
+  err = memo_init (&memo, &dfa->fwd);
+  if (__glibc_unlikely (err != REG_NOERROR))
+    return err;
+  for (match_first = start; ; match_first += step)
+    {
+      if (step > 0 && !dfa->can_be_null && match_first < last_start)
+	match_first += simd_byteset_scan (&dfa->first_scan,
+					  string + match_first,
+					  last_start - match_first);
+      if (dfa->can_be_null || match_first == length
+	  || bitset_contain (dfa->firstset, string[match_first]))
+	{
+	  err = backtrack_match (dfa, string, length, match_first, stop,
+				 eflags, caps, ncap, &memo);
+	  if (err == REG_NOERROR && dfa->earliest && step > 0)
+	    {
+	      /* A match that starts later may still end sooner.  */
+	      found = true;
+	      stop = caps[1] - 1;
+	    }
+	  else if (err != REG_NOMATCH)
+	    break;
+	}
+      if (match_first == last_start || (found && match_first >= stop))
+	{
+	  err = found ? REG_NOERROR : REG_NOMATCH;
+	  break;
+	}
+    }
+  re_free (memo.slots);
+  return err;
+}
+
+/* Searches for a compiled pattern PREG in the string STRING, whose
+   length is LENGTH.  NMATCH, PMATCH, and EFLAGS have the same
+   meaning as with regexec.  LAST_START is START + RANGE, where
+   START and RANGE have the same meaning as with re_search.
+   Return REG_NOERROR if we find a match, and REG_NOMATCH if not,
+   otherwise return the error code.
+   Note: We assume front end functions already check ranges.
+   (0 <= LAST_START && LAST_START <= LENGTH)  */
+
+static reg_errcode_t
+re_search_internal (const regex_t *preg, const char *string, Idx length,
+		    Idx start, Idx last_start, Idx stop, size_t nmatch,
+		    regmatch_t pmatch[], int eflags)
+{
+  re_dfa_t *dfa = preg->buffer;
+  const unsigned char *s = (const unsigned char *) string;
+  reg_errcode_t err;
+  regoff_t *caps = NULL;
+  Idx ncap;
+  size_t extra_nmatch;
+  size_t i;
+
+  if (__glibc_unlikely (preg->used == 0 || dfa->fwd.ninsts == 0))
+    return REG_NOMATCH;
+  if (__glibc_unlikely (start < 0 || start > length
+			|| last_start < 0 || last_start > length))
+    return REG_NOMATCH;
+  if (stop > length)
+    stop = length;
+  if (__glibc_unlikely (stop < start && stop < last_start))
+    return REG_NOMATCH;
+
+  /* Searching forwards, the DFA looks for the required string itself
+     as it goes.  */
+  if (dfa->must_len > 0 && start >= last_start
+      && find_must (dfa, s, last_start, stop) < 0)
+    return REG_NOMATCH;
+
+  /* sed sets newline_anchor after compiling the pattern.  */
+  if (__glibc_unlikely (dfa->newline_anchor != !!preg->newline_anchor))
+    {
+      re_dfa_set_context (dfa, preg->newline_anchor);
+      re_prog_flush (&dfa->fwd);
+      if (dfa->rev.ninsts != 0)
+	re_prog_flush (&dfa->rev);
+    }
+
+  extra_nmatch = (nmatch > preg->re_nsub) ? nmatch - (preg->re_nsub + 1) : 0;
+  nmatch -= extra_nmatch;
+
+  /* Backreferences need the registers they refer to.  */
+  ncap = 2 * nmatch;
+  if (dfa->nbackref != 0)
+    ncap = 2 * (preg->re_nsub + 1);
+  if (ncap != 0)
+    {
+      caps = re_malloc (regoff_t, ncap);
+      if (__glibc_unlikely (caps == NULL))
+	return REG_ESPACE;
+    }
+
+  if (dfa->literals != NULL)
+    err = search_literals (dfa, s, start, last_start, stop, caps, ncap);
+  else if (dfa->nbackref == 0)
+    err = search_no_backref (dfa, s, length, start, last_start, stop,
+			     eflags, caps, ncap);
+  else
+    err = search_backref (dfa, s, length, start, last_start, stop,
+			  eflags, caps, ncap);
+
+  if (err == REG_NOERROR)
+    {
+      for (i = 0; i < nmatch; ++i)
+	{
+	  pmatch[i].rm_so = caps[2 * i];
+	  pmatch[i].rm_eo = caps[2 * i + 1];
+	  if (pmatch[i].rm_so == -1 || pmatch[i].rm_eo == -1
+	      || pmatch[i].rm_eo < pmatch[i].rm_so)
+	    pmatch[i].rm_so = pmatch[i].rm_eo = -1;
+	}
+      for (i = nmatch; i < nmatch + extra_nmatch; ++i)
+	pmatch[i].rm_so = pmatch[i].rm_eo = -1;
+    }
+  re_free (caps);
+  return err;
+}
@@ -0,0 +1,158 @@
+/* scratch.c - per-thread scratch obstacks with nested scopes
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification.  */
+#include "scratch.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/* Preferred chunk size of a scratch obstack.  */
+#ifndef SCRATCH_CHUNK_SIZE
+# define SCRATCH_CHUNK_SIZE (64 * 1024)
+#endif
+
+/* Number of released chunks a thread keeps for reuse.  */
+#ifndef SCRATCH_CACHED_CHUNKS
+# define SCRATCH_CACHED_CHUNKS 8
+#endif
+
+/* Header in front of every chunk, recording how big it really is, since
+   the obstack may use a cached chunk for a smaller request.  */
+
+union scratch_block
+{
+  struct
+  {
+    union scratch_block *next;  /* next cached block */
+    size_t size;                /* usable bytes after the header */
+  } h;
+  max_align_t align;
+};
+
+struct scratch_arena
+{
+  struct obstack obstack;
+  union scratch_block *cache;   /* released chunks, kept for reuse */
+  unsigned ncached;
+  int ready;
+};
+
+static __thread struct scratch_arena arena;
+
+static pthread_key_t arena_key;
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+
+/* Chunk functions of a scratch obstack; ARG is its scratch_arena.  */
+
+static void *
+scratch_chunk_alloc (void *arg, size_t size)
+{
+  struct scratch_arena *a = arg;
+  union scratch_block **p, *b;
+
+  for (p = &a->cache; (b = *p) != NULL; p = &b->h.next)
+    if (b->h.size >= size)
+      {
+        *p = b->h.next;
+        a->ncached--;
+        return b + 1;
+      }
+
+  b = malloc (sizeof *b + size);
+  if (!b)
+    return NULL;
+  b->h.size = size;
+  return b + 1;
+}
+
+static void
+scratch_chunk_free (void *arg, void *chunk)
+{
+  struct scratch_arena *a = arg;
+  union scratch_block *b = (union scratch_block *) chunk - 1;
+
+  if (a->ncached < SCRATCH_CACHED_CHUNKS)
+    {
+      b->h.next = a->cache;
+      a->cache = b;
+      a->ncached++;
+    }
+  else
+    free (b);
+}
+
+/* Free everything a thread's arena holds when the thread exits.  */
+
+static void
+arena_destroy (void *arg)
+{
+  struct scratch_arena *a = arg;
+  union scratch_block *b;
+
+  obstack_free (&a->obstack, NULL);
+  while ((b = a->cache) != NULL)
+    {
+      a->cache = b->h.next;
+      free (b);
+    }
+  a->ncached = 0;
+  a->ready = 0;
+}
+
+static void
+arena_key_create (void)
+{
+  pthread_key_create (&arena_key, arena_destroy);
+}
+
+/* Open a scratch scope in the calling thread.  */
+
+struct scratch
+scratch_begin (void)
+{
+  struct scratch s;
+  struct obstack *h = &arena.obstack;
+
+  if (!arena.ready)
+    {
+      pthread_once (&arena_once, arena_key_create);
+      obstack_specify_allocation_with_arg (h, SCRATCH_CHUNK_SIZE, 0,
+                                           scratch_chunk_alloc,
+                                           scratch_chunk_free, &arena);
+      pthread_setspecific (arena_key, &arena);
+      arena.ready = 1;
+    }
+
+  /* Finishing the current object gives a mark to rewind to, even if the
+     object is empty, and keeps a growing object out of the way of the
+     scope's allocations.  */
+  s.obstack = h;
+  s.grow = obstack_object_size (h);
+  s.mark = obstack_finish (h);
+  return s;
+}
+
+/* Close scope S, freeing everything allocated since it was opened, and
+   resume growing the object that was growing then, if any.  */
+
+void
+scratch_end (struct scratch s)
+{
+  obstack_free (s.obstack, s.mark);
+  obstack_blank_fast (s.obstack, s.grow);
+}
@@ -0,0 +1,69 @@
+/* scratch.h - per-thread scratch obstacks with nested scopes
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   Each thread owns one obstack for temporary memory.  A function that
+   needs memory only until it returns opens a scope with scratch_begin,
+   allocates from the scope's obstack with the usual obstack macros, and
+   closes the scope with scratch_end, which frees everything allocated
+   since scratch_begin.
+
+        struct scratch s = scratch_begin ();
+        char *buf = scratch_alloc (s, n);
+        ...
+        scratch_end (s);
+
+   Scopes nest: a function called inside a scope may open its own, as
+   long as scopes are closed in the reverse order of opening.  An object
+   still growing in the scratch obstack when a nested scope opens is set
+   aside and resumes growing once that scope closes.
+
+   Chunks released when a scope closes stay cached in the thread, so
+   that after warming up a scope costs a bump and a rewind.  */
+
+#ifndef _SCRATCH_H
+#define _SCRATCH_H 1
+
+#include "obstack.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct scratch          /* token for an open scratch scope */
+{
+  struct obstack *obstack;      /* the thread's scratch obstack */
+  void *mark;                   /* everything from here on is freed */
+  _OBSTACK_SIZE_T grow;         /* size of the object set aside, if any */
+};
+
+extern struct scratch scratch_begin (void);
+extern void scratch_end (struct scratch);
+
+/* The obstack of scope S, for use with any obstack macro.  */
+
+#define scratch_obstack(s) ((s).obstack)
+
+/* Allocate N bytes, aligned as for any object, that live until S ends.  */
+
+#define scratch_alloc(s, n) obstack_alloc ((s).obstack, (n))
+
+#ifdef __cplusplus
+}       /* C++ */
+#endif
+
+#endif /* _SCRATCH_H */
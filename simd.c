@@ -0,0 +1,569 @@
+/* simd.c - vectorized byte scanning and copying
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Specification.  */
+#include "simd.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined __x86_64__ || defined __i386__
+# include <immintrin.h>
+# define SIMD_X86 1
+#endif
+
+/* Below this many bytes, simd_memcpy leaves the copy to memcpy.  */
+#define COPY_THRESHOLD 256
+
+int
+simd_level (void)
+{
+  /* Threads calling this at once all find the same level, so each
+     merely stores it again; the atomic accesses keep that a race in
+     name only.  */
+  static int level = -1;
+  int l = __atomic_load_n (&level, __ATOMIC_RELAXED);
+
+  if (l < 0)
+    {
+      l = SIMD_SCALAR;
+#ifdef SIMD_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx512bw"))
+        l = SIMD_AVX512;
+      else if (__builtin_cpu_supports ("avx2"))
+        l = SIMD_AVX2;
+      else if (__builtin_cpu_supports ("ssse3"))
+        l = SIMD_SSSE3;
+      else if (__builtin_cpu_supports ("sse2"))
+        l = SIMD_SSE2;
+#endif
+      __atomic_store_n (&level, l, __ATOMIC_RELAXED);
+    }
+  return l;
+}
+
+void
+simd_byteset_init (struct simd_byteset *set)
+{
+  memset (set, 0, sizeof *set);
+}
+
+void
+simd_byteset_add (struct simd_byteset *set, unsigned char c)
+{
+  if (simd_byteset_contains (set, c))
+    return;
+  (c < 0x80 ? set->lo : set->hi)[c & 15] |= 1 << ((c >> 4) & 7);
+  if (set->count < 3)
+    memset (set->chars + set->count, c, 3 - set->count);
+  set->count++;
+}
+
+void
+simd_byteset_add_range (struct simd_byteset *set,
+                        unsigned char first, unsigned char last)
+{
+  unsigned int c;
+
+  for (c = first; c <= last; c++)
+    simd_byteset_add (set, c);
+}
+
+/* Portable versions.  */
+
+static size_t
+find_chars_scalar (const unsigned char *s, size_t n,
+                   const struct simd_byteset *set)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    if (s[i] == set->chars[0] || s[i] == set->chars[1]
+        || s[i] == set->chars[2])
+      break;
+  return i;
+}
+
+static size_t
+find_class_scalar (const unsigned char *s, size_t n,
+                   const struct simd_byteset *set)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    if (simd_byteset_contains (set, s[i]))
+      break;
+  return i;
+}
+
+static void *
+memccpy_scalar (void *__restrict dst, const void *__restrict src,
+                int c, size_t n)
+{
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    if ((d[i] = s[i]) == (unsigned char) c)
+      return d + i + 1;
+  return NULL;
+}
+
+static void *
+memcpy_libc (void *__restrict dst, const void *__restrict src, size_t n)
+{
+  return memcpy (dst, src, n);
+}
+
+#ifdef SIMD_X86
+
+/* Each vector version handles whole vectors and leaves the rest to the
+   portable one, except that the AVX-512 versions finish with a masked
+   load or store, which cannot fault past the end.  */
+
+__attribute__ ((__target__ ("sse2"))) static size_t
+find_chars_sse2 (const unsigned char *s, size_t n,
+                 const struct simd_byteset *set)
+{
+  const __m128i a = _mm_set1_epi8 (set->chars[0]);
+  const __m128i b = _mm_set1_epi8 (set->chars[1]);
+  const __m128i c = _mm_set1_epi8 (set->chars[2]);
+  size_t i;
+
+  for (i = 0; n - i >= 16; i += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (s + i));
+      unsigned m = _mm_movemask_epi8 (_mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (v, a),
+                                                                  _mm_cmpeq_epi8 (v, b)),
+                                                    _mm_cmpeq_epi8 (v, c)));
+      if (m)
+        return i + __builtin_ctz (m);
+    }
+  return i + find_chars_scalar (s + i, n - i, set);
+}
+
+__attribute__ ((__target__ ("avx2"))) static size_t
+find_chars_avx2 (const unsigned char *s, size_t n,
+                 const struct simd_byteset *set)
+{
+  const __m256i a = _mm256_set1_epi8 (set->chars[0]);
+  const __m256i b = _mm256_set1_epi8 (set->chars[1]);
+  const __m256i c = _mm256_set1_epi8 (set->chars[2]);
+  size_t i;
+
+  for (i = 0; n - i >= 32; i += 32)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (s + i));
+      unsigned m
+        = _mm256_movemask_epi8 (_mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, a),
+                                                                  _mm256_cmpeq_epi8 (v, b)),
+                                                 _mm256_cmpeq_epi8 (v, c)));
+      if (m)
+        return i + __builtin_ctz (m);
+    }
+  return i + find_chars_sse2 (s + i, n - i, set);
+}
+
+__attribute__ ((__target__ ("avx512bw"))) static size_t
+find_chars_avx512 (const unsigned char *s, size_t n,
+                   const struct simd_byteset *set)
+{
+  const __m512i a = _mm512_set1_epi8 (set->chars[0]);
+  const __m512i b = _mm512_set1_epi8 (set->chars[1]);
+  const __m512i c = _mm512_set1_epi8 (set->chars[2]);
+  __mmask64 live = ~(__mmask64) 0;
+  size_t i;
+
+  for (i = 0; i < n; i += 64)
+    {
+      __m512i v;
+      __mmask64 m;
+
+      if (n - i < 64)
+        live = ((__mmask64) 1 << (n - i)) - 1;
+      v = _mm512_maskz_loadu_epi8 (live, s + i);
+      m = (_mm512_cmpeq_epi8_mask (v, a) | _mm512_cmpeq_epi8_mask (v, b)
+           | _mm512_cmpeq_epi8_mask (v, c)) & live;
+      if (m)
+        return i + __builtin_ctzll (m);
+    }
+  return n;
+}
+
+/* The byte-class test: look up the low nibble of each byte in the table
+   for its top bit, and test the bit the rest of the high nibble
+   selects.  */
+
+#define CLASS_BITS 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+
+__attribute__ ((__target__ ("ssse3"))) static size_t
+find_class_ssse3 (const unsigned char *s, size_t n,
+                  const struct simd_byteset *set)
+{
+  const __m128i lo = _mm_loadu_si128 ((const __m128i *) set->lo);
+  const __m128i hi = _mm_loadu_si128 ((const __m128i *) set->hi);
+  const __m128i bits = _mm_setr_epi8 (CLASS_BITS);
+  const __m128i top = _mm_set1_epi8 (-128);
+  const __m128i nibble = _mm_set1_epi8 (0x0F);
+  size_t i;
+
+  for (i = 0; n - i >= 16; i += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (s + i));
+      __m128i t = _mm_or_si128 (_mm_shuffle_epi8 (lo, v),
+                                _mm_shuffle_epi8 (hi, _mm_xor_si128 (v, top)));
+      __m128i bit = _mm_shuffle_epi8 (bits, _mm_and_si128 (_mm_srli_epi16 (v, 4),
+                                                           nibble));
+      unsigned m = ~_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_and_si128 (t, bit),
+                                                       _mm_setzero_si128 ()))
+                   & 0xFFFF;
+      if (m)
+        return i + __builtin_ctz (m);
+    }
+  return i + find_class_scalar (s + i, n - i, set);
+}
+
+__attribute__ ((__target__ ("avx2"))) static size_t
+find_class_avx2 (const unsigned char *s, size_t n,
+                 const struct simd_byteset *set)
+{
+  const __m256i lo
+    = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) set->lo));
+  const __m256i hi
+    = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) set->hi));
+  const __m256i bits = _mm256_setr_epi8 (CLASS_BITS, CLASS_BITS);
+  const __m256i top = _mm256_set1_epi8 (-128);
+  const __m256i nibble = _mm256_set1_epi8 (0x0F);
+  size_t i;
+
+  for (i = 0; n - i >= 32; i += 32)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (s + i));
+      __m256i t = _mm256_or_si256 (_mm256_shuffle_epi8 (lo, v),
+                                   _mm256_shuffle_epi8 (hi, _mm256_xor_si256 (v, top)));
+      __m256i bit = _mm256_shuffle_epi8 (bits,
+                                         _mm256_and_si256 (_mm256_srli_epi16 (v, 4),
+                                                           nibble));
+      unsigned m = ~_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_and_si256 (t, bit),
+                                                             _mm256_setzero_si256 ()));
+      if (m)
+        return i + __builtin_ctz (m);
+    }
+  return i + find_class_ssse3 (s + i, n - i, set);
+}
+
+__attribute__ ((__target__ ("avx512bw"))) static size_t
+find_class_avx512 (const unsigned char *s, size_t n,
+                   const struct simd_byteset *set)
+{
+  const __m512i lo
+    = _mm512_broadcast_i32x4 (_mm_loadu_si128 ((const __m128i *) set->lo));
+  const __m512i hi
+    = _mm512_broadcast_i32x4 (_mm_loadu_si128 ((const __m128i *) set->hi));
+  const __m512i bits = _mm512_broadcast_i32x4 (_mm_setr_epi8 (CLASS_BITS));
+  const __m512i top = _mm512_set1_epi8 (-128);
+  const __m512i nibble = _mm512_set1_epi8 (0x0F);
+  __mmask64 live = ~(__mmask64) 0;
+  size_t i;
+
+  for (i = 0; i < n; i += 64)
+    {
+      __m512i v, t, bit;
+      __mmask64 m;
+
+      if (n - i < 64)
+        live = ((__mmask64) 1 << (n - i)) - 1;
+      v = _mm512_maskz_loadu_epi8 (live, s + i);
+      t = _mm512_or_si512 (_mm512_shuffle_epi8 (lo, v),
+                           _mm512_shuffle_epi8 (hi, _mm512_xor_si512 (v, top)));
+      bit = _mm512_shuffle_epi8 (bits, _mm512_and_si512 (_mm512_srli_epi16 (v, 4),
+                                                         nibble));
+      m = _mm512_test_epi8_mask (t, bit) & live;
+      if (m)
+        return i + __builtin_ctzll (m);
+    }
+  return n;
+}
+
+__attribute__ ((__target__ ("sse2"))) static void *
+memccpy_sse2 (void *__restrict dst, const void *__restrict src,
+              int c, size_t n)
+{
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  const __m128i cc = _mm_set1_epi8 (c);
+  size_t i;
+
+  for (i = 0; n - i >= 16; i += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (s + i));
+      unsigned m = _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, cc));
+
+      if (m)
+        {
+          size_t k = __builtin_ctz (m) + 1;
+          memcpy (d + i, s + i, k);
+          return d + i + k;
+        }
+      _mm_storeu_si128 ((__m128i *) (d + i), v);
+    }
+  return memccpy_scalar (d + i, s + i, c, n - i);
+}
+
+__attribute__ ((__target__ ("avx2"))) static void *
+memccpy_avx2 (void *__restrict dst, const void *__restrict src,
+              int c, size_t n)
+{
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  const __m256i cc = _mm256_set1_epi8 (c);
+  size_t i;
+
+  for (i = 0; n - i >= 32; i += 32)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (s + i));
+      unsigned m = _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, cc));
+
+      if (m)
+        {
+          size_t k = __builtin_ctz (m) + 1;
+          memcpy (d + i, s + i, k);
+          return d + i + k;
+        }
+      _mm256_storeu_si256 ((__m256i *) (d + i), v);
+    }
+  return memccpy_sse2 (d + i, s + i, c, n - i);
+}
+
+__attribute__ ((__target__ ("avx512bw"))) static void *
+memccpy_avx512 (void *__restrict dst, const void *__restrict src,
+                int c, size_t n)
+{
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  const __m512i cc = _mm512_set1_epi8 (c);
+  __mmask64 live = ~(__mmask64) 0;
+  size_t i;
+
+  for (i = 0; i < n; i += 64)
+    {
+      __m512i v;
+      __mmask64 m;
+
+      if (n - i < 64)
+        live = ((__mmask64) 1 << (n - i)) - 1;
+      v = _mm512_maskz_loadu_epi8 (live, s + i);
+      m = _mm512_cmpeq_epi8_mask (v, cc) & live;
+      if (m)
+        {
+          /* Store up to and including the first match.  */
+          _mm512_mask_storeu_epi8 (d + i, m ^ (m - 1), v);
+          return d + i + __builtin_ctzll (m) + 1;
+        }
+      _mm512_mask_storeu_epi8 (d + i, live, v);
+    }
+  return NULL;
+}
+
+/* Large copies, four vectors at a time.  The last four vectors are
+   copied from the end, overlapping what came before.  */
+
+__attribute__ ((__target__ ("avx2"))) static void *
+memcpy_avx2 (void *__restrict dst, const void *__restrict src, size_t n)
+{
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  __m256i t0, t1, t2, t3;
+  size_t i;
+
+  if (n < COPY_THRESHOLD)
+    return memcpy (dst, src, n);
+  for (i = 0; n - i > 128; i += 128)
+    {
+      t0 = _mm256_loadu_si256 ((const __m256i *) (s + i));
+      t1 = _mm256_loadu_si256 ((const __m256i *) (s + i + 32));
+      t2 = _mm256_loadu_si256 ((const __m256i *) (s + i + 64));
+      t3 = _mm256_loadu_si256 ((const __m256i *) (s + i + 96));
+      _mm256_storeu_si256 ((__m256i *) (d + i), t0);
+      _mm256_storeu_si256 ((__m256i *) (d + i + 32), t1);
+      _mm256_storeu_si256 ((__m256i *) (d + i + 64), t2);
+      _mm256_storeu_si256 ((__m256i *) (d + i + 96), t3);
+    }
+  t0 = _mm256_loadu_si256 ((const __m256i *) (s + n - 128));
+  t1 = _mm256_loadu_si256 ((const __m256i *) (s + n - 96));
+  t2 = _mm256_loadu_si256 ((const __m256i *) (s + n - 64));
+  t3 = _mm256_loadu_si256 ((const __m256i *) (s + n - 32));
+  _mm256_storeu_si256 ((__m256i *) (d + n - 128), t0);
+  _mm256_storeu_si256 ((__m256i *) (d + n - 96), t1);
+  _mm256_storeu_si256 ((__m256i *) (d + n - 64), t2);
+  _mm256_storeu_si256 ((__m256i *) (d + n - 32), t3);
+  return dst;
+}
+
+__attribute__ ((__target__ ("avx512bw"))) static void *
+memcpy_avx512 (void *__restrict dst, const void *__restrict src, size_t n)
+{
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  __m512i t0, t1, t2, t3;
+  size_t i;
+
+  if (n < COPY_THRESHOLD)
+    return memcpy (dst, src, n);
+  for (i = 0; n - i > 256; i += 256)
+    {
+      t0 = _mm512_loadu_si512 (s + i);
+      t1 = _mm512_loadu_si512 (s + i + 64);
+      t2 = _mm512_loadu_si512 (s + i + 128);
+      t3 = _mm512_loadu_si512 (s + i + 192);
+      _mm512_storeu_si512 (d + i, t0);
+      _mm512_storeu_si512 (d + i + 64, t1);
+      _mm512_storeu_si512 (d + i + 128, t2);
+      _mm512_storeu_si512 (d + i + 192, t3);
+    }
+  t0 = _mm512_loadu_si512 (s + n - 256);
+  t1 = _mm512_loadu_si512 (s + n - 192);
+  t2 = _mm512_loadu_si512 (s + n - 128);
+  t3 = _mm512_loadu_si512 (s + n - 64);
+  _mm512_storeu_si512 (d + n - 256, t0);
+  _mm512_storeu_si512 (d + n - 192, t1);
+  _mm512_storeu_si512 (d + n - 128, t2);
+  _mm512_storeu_si512 (d + n - 64, t3);
+  return dst;
+}
+
+#endif
+
+/* The kernels in use.  Each starts as a function that chooses all of
+   them and then calls the one it stood for.  Threads that make their
+   first calls at once all choose the same kernels, so the pointers are
+   only ever replaced by equal ones; they are read and written with
+   relaxed atomic accesses so that this is not a data race.  */
+
+typedef size_t (*find_fn) (const unsigned char *, size_t,
+                           const struct simd_byteset *);
+
+static size_t find_chars_init (const unsigned char *, size_t,
+                               const struct simd_byteset *);
+static size_t find_class_init (const unsigned char *, size_t,
+                               const struct simd_byteset *);
+static void *memccpy_init (void *__restrict, const void *__restrict,
+                           int, size_t);
+static void *memcpy_init (void *__restrict, const void *__restrict, size_t);
+
+static find_fn find_chars = find_chars_init;
+static find_fn find_class = find_class_init;
+static void *(*memccpy_fn) (void *__restrict, const void *__restrict,
+                            int, size_t) = memccpy_init;
+static void *(*memcpy_fn) (void *__restrict, const void *__restrict,
+                           size_t) = memcpy_init;
+
+static void
+choose_kernels (void)
+{
+  int level = simd_level ();
+  find_fn chars = find_chars_scalar;
+  find_fn class = find_class_scalar;
+  void *(*ccpy) (void *__restrict, const void *__restrict,
+                 int, size_t) = memccpy_scalar;
+  void *(*cpy) (void *__restrict, const void *__restrict,
+                size_t) = memcpy_libc;
+
+#ifdef SIMD_X86
+  if (level >= SIMD_SSE2)
+    {
+      chars = find_chars_sse2;
+      ccpy = memccpy_sse2;
+    }
+  if (level >= SIMD_SSSE3)
+    class = find_class_ssse3;
+  if (level >= SIMD_AVX2)
+    {
+      chars = find_chars_avx2;
+      class = find_class_avx2;
+      ccpy = memccpy_avx2;
+      cpy = memcpy_avx2;
+    }
+  if (level >= SIMD_AVX512)
+    {
+      chars = find_chars_avx512;
+      class = find_class_avx512;
+      ccpy = memccpy_avx512;
+      cpy = memcpy_avx512;
+    }
+#else
+  (void) level;
+#endif
+  __atomic_store_n (&find_chars, chars, __ATOMIC_RELAXED);
+  __atomic_store_n (&find_class, class, __ATOMIC_RELAXED);
+  __atomic_store_n (&memccpy_fn, ccpy, __ATOMIC_RELAXED);
+  __atomic_store_n (&memcpy_fn, cpy, __ATOMIC_RELAXED);
+}
+
+static size_t
+find_chars_init (const unsigned char *s, size_t n,
+                 const struct simd_byteset *set)
+{
+  choose_kernels ();
+  return __atomic_load_n (&find_chars, __ATOMIC_RELAXED) (s, n, set);
+}
+
+static size_t
+find_class_init (const unsigned char *s, size_t n,
+                 const struct simd_byteset *set)
+{
+  choose_kernels ();
+  return __atomic_load_n (&find_class, __ATOMIC_RELAXED) (s, n, set);
+}
+
+static void *
+memccpy_init (void *__restrict dst, const void *__restrict src,
+              int c, size_t n)
+{
+  choose_kernels ();
+  return __atomic_load_n (&memccpy_fn, __ATOMIC_RELAXED) (dst, src, c, n);
+}
+
+static void *
+memcpy_init (void *__restrict dst, const void *__restrict src, size_t n)
+{
+  choose_kernels ();
+  return __atomic_load_n (&memcpy_fn, __ATOMIC_RELAXED) (dst, src, n);
+}
+
+size_t
+simd_byteset_scan (const struct simd_byteset *set, const void *s, size_t n)
+{
+  if (set->count == 0)
+    return n;
+  return __atomic_load_n (set->count <= 3 ? &find_chars : &find_class,
+                          __ATOMIC_RELAXED) (s, n, set);
+}
+
+void *
+simd_memccpy (void *__restrict dst, const void *__restrict src,
+              int c, size_t n)
+{
+  return __atomic_load_n (&memccpy_fn, __ATOMIC_RELAXED) (dst, src, c, n);
+}
+
+void *
+simd_memcpy (void *__restrict dst, const void *__restrict src, size_t n)
+{
+  return __atomic_load_n (&memcpy_fn, __ATOMIC_RELAXED) (dst, src, n);
+}
@@ -0,0 +1,95 @@
+/* simd.h - vectorized byte scanning and copying
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This file is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   This file is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Summary:
+
+   Kernels shared by the rest of the library for the byte loops it
+   spends its time in: finding the first byte of a set, copying up to a
+   byte, and copying.  Each has SSE2 (or SSSE3), AVX2 and AVX-512
+   versions on x86, and portable C elsewhere.  The widest version the
+   CPU supports is chosen on the first call of each kernel, from whatever
+   thread; libc's ifunc is not used, since musl has none.
+   tests/test-simd.c checks the vector versions against the portable
+   ones.
+
+   A set of bytes is prepared once and can then be searched for any
+   number of times:
+
+        struct simd_byteset set;
+        simd_byteset_init (&set);
+        simd_byteset_add_range (&set, 0, 0x1F);
+        simd_byteset_add (&set, '"');
+        n = simd_byteset_scan (&set, s, len);     -- S[N] is the first
+                                                     member, or N is LEN
+
+   Sets of up to three bytes are searched for by comparing with each;
+   larger sets by looking up both nibbles of each byte in 16-byte
+   tables, as in the "truffle" method of Hyperscan.  */
+
+#ifndef _SIMD_H
+#define _SIMD_H 1
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The instruction sets usable on this CPU, in increasing order.  */
+enum
+{
+  SIMD_SCALAR,
+  SIMD_SSE2,
+  SIMD_SSSE3,
+  SIMD_AVX2,
+  SIMD_AVX512                   /* with the byte and word instructions */
+};
+
+extern int simd_level (void);
+
+struct simd_byteset
+{
+  /* Bit H of LO[L] is set if byte 0xHL is in the set, for H < 8, and
+     bit H - 8 of HI[L] for H >= 8.  */
+  unsigned char lo[16];
+  unsigned char hi[16];
+  unsigned short count;         /* number of members */
+  unsigned char chars[3];       /* if COUNT <= 3, the members, repeated to
+                                   fill the array */
+};
+
+extern void simd_byteset_init (struct simd_byteset *);
+extern void simd_byteset_add (struct simd_byteset *, unsigned char);
+extern void simd_byteset_add_range (struct simd_byteset *,
+                                    unsigned char, unsigned char);
+
+#define simd_byteset_contains(set, c) \
+  ((((c) < 0x80 ? (set)->lo : (set)->hi)[(c) & 15] >> (((c) >> 4) & 7)) & 1)
+
+/* Return the index of the first of the N bytes at S in SET, or N.  */
+extern size_t simd_byteset_scan (const struct simd_byteset *,
+                                 const void *, size_t);
+
+/* As memccpy and memcpy.  */
+extern void *simd_memccpy (void *__restrict, const void *__restrict,
+                           int, size_t);
+extern void *simd_memcpy (void *__restrict, const void *__restrict, size_t);
+
+#ifdef __cplusplus
+}       /* C++ */
+#endif
+
+#endif /* _SIMD_H */
@@ -0,0 +1,209 @@
+/* Test of the vectorized byte kernels against the portable ones.
+   Copyright (C) 2023 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* Build and run from the top directory with
+
+        cc -O2 -I. tests/test-simd.c -o test-simd && ./test-simd
+
+   The kernels are static, so simd.c is included rather than linked.
+   Each one the CPU supports is run on random sets, lengths and
+   alignments, with its input ending just before an inaccessible page,
+   and must give the same result as the portable kernel, leave the same
+   destination bytes and touch nothing past the end.  */
+
+#include "simd.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define ASSERT(expr) \
+  do                                                                    \
+    {                                                                   \
+      if (!(expr))                                                      \
+        {                                                               \
+          fprintf (stderr, "%s:%d: assertion '%s' failed"               \
+                   " (%s, length %zu, offset %zu)\n",                   \
+                   __FILE__, __LINE__, #expr, k->name, n, off);         \
+          abort ();                                                     \
+        }                                                               \
+    }                                                                   \
+  while (0)
+
+/* Room for the longest input, which ends at the end of its area.  */
+#define AREA 8192
+
+#define ROUNDS 200000
+
+typedef void *(*memccpy_kernel) (void *__restrict, const void *__restrict,
+                                 int, size_t);
+typedef void *(*memcpy_kernel) (void *__restrict, const void *__restrict,
+                                size_t);
+
+/* The kernels each level adds; null where it adds none.  */
+struct kernels
+{
+  const char *name;
+  int level;
+  find_fn chars;
+  find_fn class;
+  memccpy_kernel ccpy;
+  memcpy_kernel cpy;
+};
+
+static const struct kernels kernels[] =
+{
+#ifdef SIMD_X86
+  { "sse2", SIMD_SSE2, find_chars_sse2, NULL, memccpy_sse2, NULL },
+  { "ssse3", SIMD_SSSE3, NULL, find_class_ssse3, NULL, NULL },
+  { "avx2", SIMD_AVX2, find_chars_avx2, find_class_avx2, memccpy_avx2,
+    memcpy_avx2 },
+  { "avx512", SIMD_AVX512, find_chars_avx512, find_class_avx512,
+    memccpy_avx512, memcpy_avx512 },
+#endif
+  { "scalar", SIMD_SCALAR, NULL, NULL, NULL, NULL }
+};
+
+/* Return a writable area of AREA bytes followed by an inaccessible
+   page.  */
+static unsigned char *
+guarded_area (void)
+{
+  size_t page = sysconf (_SC_PAGESIZE);
+  size_t size = (AREA + page - 1) / page * page;
+  unsigned char *p = mmap (NULL, size + page, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (p == MAP_FAILED || mprotect (p + size, page, PROT_NONE) != 0)
+    {
+      perror ("mmap");
+      exit (1);
+    }
+  return p + size - AREA;
+}
+
+/* Mostly lengths around a few vectors, tails shorter than one
+   included; now and then long ones.  */
+static size_t
+random_length (void)
+{
+  switch (rand () % 8)
+    {
+    case 0:
+      return rand () % 16;
+    case 1:
+      return rand () % (AREA - 64);
+    default:
+      return rand () % 600;
+    }
+}
+
+/* Make SET a random set of up to MAX members, and return one of them.  */
+static unsigned char
+random_set (struct simd_byteset *set, int max)
+{
+  int count = 1 + rand () % max;
+  unsigned char c = rand ();
+
+  simd_byteset_init (set);
+  if (max > 3 && rand () % 4 == 0)
+    {
+      unsigned char first = rand ();
+      simd_byteset_add_range (set, first,
+                              first + rand () % (256 - first));
+      return first;
+    }
+  while (count--)
+    {
+      c = rand ();
+      simd_byteset_add (set, c);
+    }
+  return c;
+}
+
+/* Fill the N bytes at S with random bytes, with a few occurrences of C,
+   from none to many.  */
+static void
+random_fill (unsigned char *s, size_t n, unsigned char c)
+{
+  int every = 1 << (rand () % 12);
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    s[i] = rand () % every == 0 ? c : rand ();
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned char *src = guarded_area ();
+  unsigned char *dst = guarded_area ();
+  unsigned char *ref = guarded_area ();
+  int level = simd_level ();
+  long rounds = argc > 1 ? atol (argv[1]) : ROUNDS;
+  const struct kernels *k;
+  long r;
+
+  srand (argc > 2 ? atoi (argv[2]) : 1);
+  for (k = kernels; k->level != SIMD_SCALAR; k++)
+    {
+      if (k->level > level)
+        {
+          printf ("%s: not supported, skipped\n", k->name);
+          continue;
+        }
+      for (r = 0; r < rounds; r++)
+        {
+          struct simd_byteset set;
+          size_t n = random_length ();
+          /* Half the time the input ends right at the inaccessible
+             page, so that reading past it faults.  */
+          size_t off = rand () % 2 ? 0 : rand () % 64;
+          unsigned char *s = src + AREA - off - n;
+          unsigned char *d = dst + AREA - n - rand () % 64;
+          unsigned char *e = ref + (d - dst);
+          unsigned char c = random_set (&set, k->class ? 40 : 3);
+
+          random_fill (s, n, c);
+          if (k->chars && set.count <= 3)
+            ASSERT (k->chars (s, n, &set) == find_chars_scalar (s, n, &set));
+          if (k->class)
+            ASSERT (k->class (s, n, &set) == find_class_scalar (s, n, &set));
+          if (k->ccpy)
+            {
+              unsigned char *got, *want;
+
+              memset (dst, 0xAA, AREA);
+              memset (ref, 0xAA, AREA);
+              got = k->ccpy (d, s, c, n);
+              want = memccpy_scalar (e, s, c, n);
+              ASSERT (want ? got - d == want - e : !got);
+              ASSERT (memcmp (dst, ref, AREA) == 0);
+            }
+          if (k->cpy)
+            {
+              memset (dst, 0xAA, AREA);
+              memset (ref, 0xAA, AREA);
+              ASSERT (k->cpy (d, s, n) == d);
+              memcpy (e, s, n);
+              ASSERT (memcmp (dst, ref, AREA) == 0);
+            }
+        }
+      printf ("%s: %ld rounds passed\n", k->name, rounds);
+    }
+  return 0;
+}